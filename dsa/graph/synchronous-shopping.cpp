@@ -15,6 +15,11 @@
 
 #define HACKER_RANK 0
 
+// Build with -DBENCHMARK=1 to benchmark dijkstra on a generated graph instead of solving input.txt
+#ifndef BENCHMARK
+#define BENCHMARK 0
+#endif
+
 constexpr char INPUT[] = "./input.txt";
 constexpr int MAX_FISH = 10;
 
@@ -269,11 +274,63 @@ std::vector<std::pair<int, int>> dijkstra(State & s, const int start)
         }
     }
 
+#if !BENCHMARK
     cout << i << "\n";
+#endif // BENCHMARK
 
     return paths;
 }
 
+#if BENCHMARK
+#include <random>
+#include "../../experiments/C/common/bench.h"
+
+constexpr int BENCH_SHOPS = 100;
+constexpr int BENCH_ROADS = 200;
+
+// Random connected graph: a chain of roads through every shop plus random extra roads
+State generate_state(const int n, const int m, const int k)
+{
+    std::mt19937 rng(1);
+    State s;
+    s._max_fish = 0x3FF >> (MAX_FISH - k);
+    s._shops.resize(n);
+    for(int i = 0; i < n; i++)
+    {
+        s._shops[i]._fish = rng() & rng() & s._max_fish; // About a quarter of the fish types per shop
+    }
+    for(int i = 0; i < m; i++)
+    {
+        const int left  = (i < n - 1) ? i : rng() % n;
+        const int right = (i < n - 1) ? i + 1 : rng() % n;
+        const int cost  = 1 + rng() % 100;
+        if(left != right)
+        {
+            s._shops[left]._neighbours[right] = cost;
+            s._shops[right]._neighbours[left] = cost;
+        }
+    }
+    return s;
+}
+
+void run_dijkstra(void * context)
+{
+    dijkstra(*static_cast<State *>(context), 0);
+}
+
+// synchronous-shopping [benchmark options]
+int main(int argc, char * argv[])
+{
+    if(Bench_namespace.Init(argc, argv, "shopping") < 0)
+    {
+        return 1;
+    }
+    State s = generate_state(BENCH_SHOPS, BENCH_ROADS, MAX_FISH);
+    const Benchmark benchmark = {"dijkstra", nullptr, run_dijkstra, &s, 1};
+    Bench_namespace.Run(&benchmark);
+    return Bench_namespace.Finish();
+}
+#else
 int main()
 {
 #if HACKER_RANK == 1
@@ -347,6 +404,7 @@ int main()
     return 0;
 #endif // HACKER_RANK
 }
+#endif // BENCHMARK
 
 #pragma region // utils
 
@@ -356,7 +414,7 @@ std::string ltrim(const std::string & str)
 
     s.erase(
         s.begin(),
-        std::find_if(s.begin(), s.end(), std::not1(std::ptr_fun<int, int>(isspace)))
+        std::find_if(s.begin(), s.end(), [](unsigned char c) { return !isspace(c); })
     );
 
     return s;
@@ -367,7 +425,7 @@ std::string rtrim(const std::string & str)
     std::string s(str);
 
     s.erase(
-        std::find_if(s.rbegin(), s.rend(), std::not1(std::ptr_fun<int, int>(isspace))).base(),
+        std::find_if(s.rbegin(), s.rend(), [](unsigned char c) { return !isspace(c); }).base(),
         s.end()
     );
 
@@ -113,7 +113,7 @@ int MoveUp(void)
 	int moved = 0;
 	for(int i = 0; i < 4; i++)
 	{
-		for(int ii = 3, done = 0; ii > 0 & !done; ii--)
+		for(int ii = 3, done = 0; ii > 0 && !done; ii--)
 		{
 			if(!nodes[ii][i].value) // Empty. Ignore
 			{
@@ -288,8 +288,71 @@ void AddRandomSquare(void)
 	nodes[empties[r].a][empties[r].b].value = randValues[rand() % ARRAY_SIZE(randValues)];
 }
 
+#ifdef BENCHMARK
+#include <string.h>
+#include "./common/bench.h"
+
+#define BENCH_BOARDS 256
+
+/*
+Random boards to play the moves on, and the move to measure
+*/
+typedef struct MoveBench
+{
+	Node boards[BENCH_BOARDS][4][4];
+	int next;
+	int (* move)(void);
+} MoveBench;
+
+/*
+Play one move on the next board. Loading the board is part of the measured time
+*/
+void PlayMove(void * context)
+{
+	MoveBench * bench = (MoveBench *)context;
+	memcpy(nodes, bench->boards[bench->next], sizeof(nodes));
+	bench->next = (bench->next + 1) % BENCH_BOARDS;
+	bench->move();
+}
+
+/*
+Benchmark the move functions on random boards
+2048 [benchmark options]
+*/
+int main(int argc, char * argv[])
+{
+	if(Bench_namespace.Init(argc, argv, "2048") < 0)
+	{
+		return 1;
+	}
+	static MoveBench bench;
+	srand(1);
+	for(int i = 0; i < BENCH_BOARDS; i++)
+	{
+		for(int ii = 0; ii < 16; ii++)
+		{
+			// About half of the squares are empty, values repeat often enough to merge
+			bench.boards[i][ii / 4][ii % 4].value = (rand() % 2) ? 1 + rand() % 4 : 0;
+			bench.boards[i][ii / 4][ii % 4].matched = 0;
+		}
+	}
+
+	const char * names[4] = {"move_up", "move_down", "move_left", "move_right"};
+	int (* moves[4])(void) = {MoveUp, MoveDown, MoveLeft, MoveRight};
+	for(int i = 0; i < 4; i++)
+	{
+		bench.next = 0;
+		bench.move = moves[i];
+		Benchmark benchmark = {names[i], NULL, PlayMove, &bench, BENCH_BOARDS};
+		Bench_namespace.Run(&benchmark);
+	}
+	return Bench_namespace.Finish();
+}
+#else
 int main(int argc, char * argv[])
 {
+	(void)argc;
+	(void)argv;
 	SDL_Window   * pWindow   = NULL;
 	SDL_Surface  * pSurface  = NULL;
 	SDL_Renderer * pRenderer = NULL;
@@ -416,3 +479,4 @@ int main(int argc, char * argv[])
 	SDL_Quit();
 	return 0;
 }
+#endif // BENCHMARK
@@ -0,0 +1,84 @@
+#include "arena.h"
+
+#include <stdlib.h>
+
+/*
+    Allocate the arena's block of memory
+    size = capacity in bytes
+*/
+static BOOL Init(Arena * arena, size_t size)
+{
+    arena->base     = (char *)malloc(size);
+    arena->size     = arena->base ? size : 0;
+    arena->offset   = 0;
+    arena->peak     = 0;
+    return arena->base != NULL;
+}
+
+/*
+    Free the arena's memory. Everything allocated from it becomes invalid
+*/
+static void Destroy(Arena * arena)
+{
+    free(arena->base);
+    arena->base     = NULL;
+    arena->size     = 0;
+    arena->offset   = 0;
+}
+
+/*
+    Allocate memory from the arena, aligned to ARENA_ALIGN
+    Return NULL if the arena does not have enough space left
+*/
+static void * Alloc(Arena * arena, size_t size)
+{
+    size_t offset = (arena->offset + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if(offset > arena->size || size > arena->size - offset)
+    {
+        return NULL;
+    }
+    arena->offset = offset + size;
+    if(arena->offset > arena->peak)
+    {
+        arena->peak = arena->offset;
+    }
+    return arena->base + offset;
+}
+
+/*
+    Return the current position of the arena, to Reset to later
+*/
+static ArenaMark Mark(Arena * arena)
+{
+    return arena->offset;
+}
+
+/*
+    Release everything allocated since the mark was taken
+*/
+static void Reset(Arena * arena, ArenaMark mark)
+{
+    if(mark < arena->offset)
+    {
+        arena->offset = mark;
+    }
+}
+
+/*
+    Release everything allocated from the arena
+*/
+static void Clear(Arena * arena)
+{
+    arena->offset = 0;
+}
+
+// Arena namespace struct, contains function pointers related to the Arena struct
+const struct arena_namespace Arena_namespace =
+{
+    .Init = Init,
+    .Destroy = Destroy,
+    .Alloc = Alloc,
+    .Mark = Mark,
+    .Reset = Reset,
+    .Clear = Clear
+};
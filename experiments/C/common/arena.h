@@ -0,0 +1,35 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "common.h"
+
+#define ARENA_ALIGN 16 // Alignment of every allocation, in bytes
+
+/*
+    Bump allocator over one fixed block of memory
+    Allocations are O(1) and never freed individually: take a Mark before a batch of
+    allocations and Reset to it afterwards to release all of them at once
+*/
+typedef struct Arena
+{
+    char * base;
+    size_t size;    // Capacity in bytes
+    size_t offset;  // Bytes in use
+    size_t peak;    // Highest offset reached, for sizing the arena
+} Arena;
+
+typedef size_t ArenaMark;
+
+typedef struct arena_namespace
+{
+    BOOL (* Init)(Arena * arena, size_t size);
+    void (* Destroy)(Arena * arena);
+    void * (* Alloc)(Arena * arena, size_t size);
+    ArenaMark (* Mark)(Arena * arena);
+    void (* Reset)(Arena * arena, ArenaMark mark);
+    void (* Clear)(Arena * arena);
+} arena_namespace;
+
+extern const struct arena_namespace Arena_namespace;
+
+#endif // ARENA_H
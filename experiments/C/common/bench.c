@@ -0,0 +1,197 @@
+#define _GNU_SOURCE
+
+#include "bench.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+    Settings shared by every benchmark of the program, from the command line
+*/
+static struct
+{
+    const char * program;
+    const char * filter;    // Only run benchmarks whose name contains this, NULL for all
+    FILE * json;            // JSON lines output, NULL for none
+    int warmup;
+    int repeats;
+} settings = {"", NULL, NULL, BENCH_WARMUP, BENCH_REPEATS};
+
+/*
+    Return monotonic time in nanoseconds
+*/
+static double Now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/*
+    qsort comparison of two doubles
+*/
+static int CompareDoubles(const void * a, const void * b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/*
+    Read the benchmark options shared by every benchmark program:
+    -w <samples>  warm-up samples (default BENCH_WARMUP)
+    -r <samples>  measured samples (default BENCH_REPEATS)
+    -f <text>     only run benchmarks whose name contains text
+    -o <file>     append results to file as JSON lines
+    program = name of the program, prefixed to every benchmark name
+    Return the index of the first argument that is not a benchmark option, or -1 on error
+*/
+static int Init(int argc, char * argv[], const char * program)
+{
+    settings.program = program;
+    int i = 1;
+    for(; i < argc; i++)
+    {
+        if(argv[i][0] != '-' || i + 1 >= argc)
+        {
+            break;
+        }
+        if(strcmp(argv[i], "-w") == 0)
+        {
+            settings.warmup = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-r") == 0)
+        {
+            settings.repeats = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-f") == 0)
+        {
+            settings.filter = argv[++i];
+        }
+        else if(strcmp(argv[i], "-o") == 0)
+        {
+            settings.json = fopen(argv[++i], "a");
+            if(!settings.json)
+            {
+                printf("openerror for file %s\n", argv[i]);
+                return -1;
+            }
+        }
+        else
+        {
+            break;
+        }
+    }
+    settings.warmup  = settings.warmup < 0 ? 0 : settings.warmup;
+    settings.repeats = settings.repeats < 1 ? 1 : settings.repeats;
+    printf("%-40s %8s %14s %14s %14s\n", "benchmark", "samples", "median ns", "p99 ns", "min ns");
+    return i;
+}
+
+/*
+    Warm up, then time the benchmark for the configured number of samples
+    Prints the median and p99 and appends them to the JSON output
+    Return the timings, with 0 samples if the benchmark was filtered out or out of memory
+*/
+static BenchResult Run(const Benchmark * benchmark)
+{
+    BenchResult result = {0, 0, 0, 0, 0};
+    if(settings.filter && !strstr(benchmark->name, settings.filter))
+    {
+        return result;
+    }
+    double * samples = (double *)malloc(settings.repeats * sizeof(double));
+    if(!samples)
+    {
+        return result;
+    }
+    int batch = benchmark->batch > 0 ? benchmark->batch : 1;
+    for(int i = -settings.warmup; i < settings.repeats; i++)
+    {
+        if(benchmark->setup)
+        {
+            benchmark->setup(benchmark->context);
+        }
+        double start = Now();
+        for(int ii = 0; ii < batch; ii++)
+        {
+            benchmark->run(benchmark->context);
+        }
+        double elapsed = (Now() - start) / batch;
+        if(i >= 0)
+        {
+            samples[i] = elapsed;
+            result.mean += elapsed / settings.repeats;
+        }
+    }
+
+    qsort(samples, settings.repeats, sizeof(double), CompareDoubles);
+    int p99 = (settings.repeats * 99 + 99) / 100 - 1; // Nearest rank
+    result.samples  = settings.repeats;
+    result.median   = (settings.repeats % 2)
+        ? samples[settings.repeats / 2]
+        : (samples[settings.repeats / 2 - 1] + samples[settings.repeats / 2]) / 2;
+    result.p99      = samples[p99];
+    result.min      = samples[0];
+    free(samples);
+
+    char name[256];
+    snprintf(name, sizeof(name), "%s/%s", settings.program, benchmark->name);
+    printf("%-40s %8d %14.1f %14.1f %14.1f\n", name, result.samples, result.median, result.p99, result.min);
+    if(settings.json)
+    {
+        fprintf(settings.json,
+            "{\"benchmark\": \"%s\", \"version\": \"%s\", \"unit\": \"ns\", \"batch\": %d, \"samples\": %d, "
+            "\"median\": %.1f, \"p99\": %.1f, \"min\": %.1f, \"mean\": %.1f}\n",
+            name, BENCH_VERSION, batch, result.samples, result.median, result.p99, result.min, result.mean);
+    }
+    return result;
+}
+
+/*
+    Report a value that is not a timing, such as work done by the measured function
+    Printed in the median column and appended to the JSON output with its unit
+    Filtered like the benchmarks, by name
+*/
+static void Metric(const char * name, const char * unit, double value)
+{
+    if(settings.filter && !strstr(name, settings.filter))
+    {
+        return;
+    }
+    char fullName[256];
+    snprintf(fullName, sizeof(fullName), "%s/%s", settings.program, name);
+    printf("%-40s %8s %14.1f %14s %14s %s\n", fullName, "", value, "", "", unit);
+    if(settings.json)
+    {
+        fprintf(settings.json, "{\"benchmark\": \"%s\", \"version\": \"%s\", \"unit\": \"%s\", \"value\": %.1f}\n",
+            fullName, BENCH_VERSION, unit, value);
+    }
+}
+
+/*
+    Close the JSON output
+    Return 0, or 1 if the results could not be written
+*/
+static int Finish(void)
+{
+    int error = 0;
+    if(settings.json)
+    {
+        error = ferror(settings.json) != 0;
+        error |= fclose(settings.json) != 0;
+        settings.json = NULL;
+    }
+    return error;
+}
+
+// Bench namespace struct, contains the benchmark harness functions
+const struct bench_namespace Bench_namespace =
+{
+    .Init = Init,
+    .Run = Run,
+    .Metric = Metric,
+    .Finish = Finish,
+    .Now = Now
+};
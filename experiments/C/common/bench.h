@@ -0,0 +1,62 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Version string written to every result, set by the makefile (git describe)
+#ifndef BENCH_VERSION
+#define BENCH_VERSION "unknown"
+#endif
+
+#define BENCH_WARMUP    3   // Default samples run and discarded before measuring
+#define BENCH_REPEATS   51  // Default samples measured
+
+/*
+    A function to measure
+    name    = unique name, written to the results as "<program>/<name>"
+    setup   = called before every sample and not timed, to restore state the function destroys. Can be NULL
+    run     = the function to measure
+    context = passed to setup and run
+    batch   = calls of run per sample, for functions too fast to time one call at a time
+*/
+typedef struct Benchmark
+{
+    const char * name;
+    void (* setup)(void * context);
+    void (* run)(void * context);
+    void * context;
+    int batch;
+} Benchmark;
+
+/*
+    Timings of one benchmark, in nanoseconds per call of run
+*/
+typedef struct BenchResult
+{
+    int samples;
+    double median;
+    double p99;
+    double min;
+    double mean;
+} BenchResult;
+
+typedef struct bench_namespace
+{
+    int (* Init)(int argc, char * argv[], const char * program);
+    BenchResult (* Run)(const Benchmark * benchmark);
+    void (* Metric)(const char * name, const char * unit, double value);
+    int (* Finish)(void);
+    double (* Now)(void);
+} bench_namespace;
+
+extern const struct bench_namespace Bench_namespace;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BENCH_H
@@ -0,0 +1,193 @@
+#include "cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    Initialise an empty cache
+    capacity = number of distance fields kept at once, each takes 4 bytes per map cell
+*/
+static BOOL Init(DistanceCache * cache, int capacity)
+{
+    cache->capacity = capacity > 0 ? capacity : 1;
+    cache->fields   = (DistanceField *)calloc(cache->capacity, sizeof(DistanceField));
+    cache->clock    = 0;
+    cache->hits     = 0;
+    cache->misses   = 0;
+    return cache->fields != NULL;
+}
+
+/*
+    Free every field and the cache
+*/
+static void Destroy(DistanceCache * cache)
+{
+    for(int i = 0; cache->fields && i < cache->capacity; i++)
+    {
+        free(cache->fields[i].distance);
+    }
+    free(cache->fields);
+    cache->fields   = NULL;
+    cache->capacity = 0;
+}
+
+/*
+    Drop every field, keeping the memory for reuse
+*/
+static void Clear(DistanceCache * cache)
+{
+    for(int i = 0; i < cache->capacity; i++)
+    {
+        cache->fields[i].map = NULL;
+    }
+}
+
+/*
+    Return the cached field of an endpoint without building it, NULL if there is none
+    Fields of an older revision of the map are dropped on the way
+*/
+static DistanceField * Lookup(DistanceCache * cache, const Map * map, Node source)
+{
+    for(int i = 0; i < cache->capacity; i++)
+    {
+        DistanceField * field = &cache->fields[i];
+        if(field->map != map)
+        {
+            continue;
+        }
+        if(field->revision != map->revision)
+        {
+            field->map = NULL;
+        }
+        else if(field->source.x == source.x && field->source.y == source.y)
+        {
+            field->used = ++cache->clock;
+            return field;
+        }
+    }
+    return NULL;
+}
+
+/*
+    Return the distance field of an endpoint, flooding the map into the least recently used slot
+    if it is not cached
+    Return NULL if memory ran out or the endpoint is a WALL or outside the map
+*/
+static const DistanceField * Field(DistanceCache * cache, const Map * map, Node source)
+{
+    DistanceField * field = Lookup(cache, map, source);
+    if(field)
+    {
+        cache->hits++;
+        return field;
+    }
+    cache->misses++;
+
+    // Empty slots have never been used, so they are picked first
+    field = &cache->fields[0];
+    for(int i = 1; i < cache->capacity && field->map; i++)
+    {
+        if(!cache->fields[i].map || cache->fields[i].used < field->used)
+        {
+            field = &cache->fields[i];
+        }
+    }
+    field->map = NULL;
+    size_t cells = (size_t)map->width * map->height;
+    if(field->cells < cells)
+    {
+        free(field->distance);
+        field->distance = (uint32_t *)malloc(cells * sizeof(uint32_t));
+        field->cells    = field->distance ? cells : 0;
+    }
+    if(!field->distance || !Solver_namespace.FloodFill(map, source, field->distance, NULL))
+    {
+        return NULL;
+    }
+    field->map      = map;
+    field->revision = map->revision;
+    field->source   = source;
+    field->used     = ++cache->clock;
+    return field;
+}
+
+/*
+    Find the shortest path between two cells of a map in O(path length) once a distance field
+    of either cell is cached. Otherwise the field of end is built first, as queries tend to share
+    their destination
+    path     = receives the cells from start to end if the path fits, can be NULL to only get the length
+    capacity = number of nodes path can hold
+    Return the number of cells of the path including both ends, or 0 if out of memory or unreachable
+*/
+static int Query(DistanceCache * cache, const Map * map, Node start, Node end, Node * path, int capacity)
+{
+    if(!MapInBounds(map, start.x, start.y) || !MapInBounds(map, end.x, end.y))
+    {
+        return 0;
+    }
+    // Walk from the far end down towards the field's source. With the field of the start the
+    // walk runs backwards, so the path is filled in from its end
+    const DistanceField * field = Lookup(cache, map, end);
+    BOOL reversed = FALSE;
+    if(!field)
+    {
+        field = Lookup(cache, map, start);
+        reversed = (field != NULL);
+    }
+    if(field)
+    {
+        cache->hits++;
+    }
+    else
+    {
+        field = Field(cache, map, end);
+    }
+    if(!field)
+    {
+        return 0;
+    }
+    Node from = reversed ? end : start;
+    int x = from.x;
+    int y = from.y;
+    uint32_t length = field->distance[(size_t)y * map->width + x];
+    if(!length || (int)length > capacity)
+    {
+        return (int)length;
+    }
+    for(uint32_t distance = length; distance > 0 && path; distance--)
+    {
+        path[reversed ? distance - 1 : length - distance].x = x;
+        path[reversed ? distance - 1 : length - distance].y = y;
+        // North
+        if(y > 0 && field->distance[(size_t)(y - 1) * map->width + x] == distance - 1)
+        {
+            y--;
+        }
+        // South
+        else if(y + 1 < map->height && field->distance[(size_t)(y + 1) * map->width + x] == distance - 1)
+        {
+            y++;
+        }
+        // East
+        else if(x + 1 < map->width && field->distance[(size_t)y * map->width + x + 1] == distance - 1)
+        {
+            x++;
+        }
+        // West
+        else if(x > 0)
+        {
+            x--;
+        }
+    }
+    return (int)length;
+}
+
+// Cache namespace struct, contains function pointers related to the DistanceCache struct
+const struct cache_namespace Cache_namespace =
+{
+    .Init = Init,
+    .Destroy = Destroy,
+    .Clear = Clear,
+    .Field = Field,
+    .Query = Query
+};
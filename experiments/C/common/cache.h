@@ -0,0 +1,48 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "common.h"
+#include "solver.h"
+
+/*
+    Distances of every cell of a map to one endpoint
+    Walking downhill from any cell leads to the endpoint along a shortest path, so the field
+    doubles as a next-hop table towards it, and paths from the endpoint are the same walk reversed
+*/
+typedef struct DistanceField
+{
+    const Map * map;        // Map the field was built from, NULL for an empty slot
+    uint64_t revision;      // Revision of the map when the field was built
+    Node source;            // The endpoint distances count from
+    uint32_t * distance;    // Distance to source plus one, row-major, 0 where it cannot be reached
+    size_t cells;           // Entries allocated in distance
+    uint64_t used;          // Cache clock of the last query, to evict the least recently used
+} DistanceField;
+
+/*
+    Fixed number of distance fields, keyed by map and endpoint
+    A field is dropped when the map's revision moved on, so any SetCell/SetRowWord edit makes
+    the next query rebuild it. Cells written with the inline MapSet/MapSetUnchecked accessors
+    are not seen until Map_namespace.Touch is called. One cache is not thread safe, give every thread its own
+*/
+typedef struct DistanceCache
+{
+    DistanceField * fields;
+    int capacity;
+    uint64_t clock;
+    size_t hits;            // Queries answered from a cached field
+    size_t misses;          // Queries that had to flood the map
+} DistanceCache;
+
+typedef struct cache_namespace
+{
+    BOOL (* Init)(DistanceCache * cache, int capacity);
+    void (* Destroy)(DistanceCache * cache);
+    void (* Clear)(DistanceCache * cache);
+    const DistanceField * (* Field)(DistanceCache * cache, const Map * map, Node source);
+    int (* Query)(DistanceCache * cache, const Map * map, Node start, Node end, Node * path, int capacity);
+} cache_namespace;
+
+extern const struct cache_namespace Cache_namespace;
+
+#endif // CACHE_H
@@ -1,62 +1,235 @@
 #include "common.h"
+#include "arena.h"
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
 
+// Nibble with its bit order reversed. The first hex digit's MSB is the leftmost cell,
+// while packed rows keep the leftmost cell in bit 0
+static const unsigned char REVERSED_NIBBLE[16] =
+{
+    0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF
+};
+#ifndef __SSSE3__
+static const char HEX_DIGITS[16] =
+{
+    '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'
+};
+#endif
+
+/*
+    Convert a single hex character into its value
+    Return -1 if the character is not a hex digit
+*/
+static int HexValue(unsigned char byte)
+{
+    if(byte >= '0' && byte <= '9')
+    {
+        return byte - '0';
+    }
+    if(byte >= 'a' && byte <= 'f')
+    {
+        return byte - 'a' + 10;
+    }
+    if(byte >= 'A' && byte <= 'F')
+    {
+        return byte - 'A' + 10;
+    }
+    return -1;
+}
+
+#ifdef __SSSE3__
 /*
-    Reverse bit order in a char
-    Return new char as an unsigned int
+    Decode 16 hex characters into one 64-bit packed row word
+    Return the number of leading characters that were hex digits; the cells of the rest are left FREE
 */
-unsigned int ReverseBits(unsigned int value)
+static int DecodeHexWord(const char * hex, uint64_t * word)
 {
-    unsigned int count = (INT_BITS - 1);
-    unsigned int tmp   = value;
-    value >>= 1; // Shift because LSB alreadt assigned to tmp
+    __m128i chars  = _mm_loadu_si128((const __m128i *)hex);
 
-    while(value)
+    // Classify: '0'-'9' and 'a'-'f'/'A'-'F' (setting 0x20 folds upper case onto lower case)
+    __m128i digit  = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+    __m128i letter = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i isDigit  = _mm_and_si128(_mm_cmpgt_epi8(digit, _mm_set1_epi8(-1)), _mm_cmplt_epi8(digit, _mm_set1_epi8(10)));
+    __m128i isLetter = _mm_and_si128(_mm_cmpgt_epi8(letter, _mm_set1_epi8(-1)), _mm_cmplt_epi8(letter, _mm_set1_epi8(6)));
+    __m128i values = _mm_or_si128(_mm_and_si128(isDigit, digit),
+                                  _mm_and_si128(isLetter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+
+    // Stop at the first non-hex character
+    int valid = _mm_movemask_epi8(_mm_or_si128(isDigit, isLetter));
+    int count = (valid == 0xFFFF) ? 16 : __builtin_ctz(~valid);
+    if(count < 16)
     {
-        tmp <<= 1; // Already have the LSB. Shift
-        tmp |= value & 1; // Putting the set of bits to num
-        value >>= 1;
-        count--;
+        __m128i lanes = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+        values = _mm_and_si128(values, _mm_cmplt_epi8(lanes, _mm_set1_epi8((char)count)));
     }
-    tmp << count; // When value is 0, shift temp from remaining counts
-    return tmp;
+
+    // Reverse each nibble, then pack pairs of nibbles into bytes: first digit in the low nibble
+    __m128i table = _mm_loadu_si128((const __m128i *)REVERSED_NIBBLE);
+    __m128i nibbles = _mm_shuffle_epi8(table, values);
+    __m128i pairs = _mm_maddubs_epi16(nibbles, _mm_set1_epi16(0x1001));
+    (*word) = (uint64_t)_mm_cvtsi128_si64(_mm_packus_epi16(pairs, pairs));
+    return count;
+}
+
+/*
+    Encode one 64-bit packed row word into 16 hex characters
+*/
+static void EncodeHexWord(uint64_t word, char * hex)
+{
+    __m128i bytes   = _mm_cvtsi64_si128((long long)word);
+    __m128i low     = _mm_and_si128(bytes, _mm_set1_epi8(0xF));
+    __m128i high    = _mm_and_si128(_mm_srli_epi16(bytes, 4), _mm_set1_epi8(0xF));
+    __m128i nibbles = _mm_unpacklo_epi8(low, high);
+
+    // Digit for every reversed nibble value, so the lookup undoes the reversal
+    __m128i table = _mm_setr_epi8('0', '8', '4', 'c', '2', 'a', '6', 'e', '1', '9', '5', 'd', '3', 'b', '7', 'f');
+    _mm_storeu_si128((__m128i *)hex, _mm_shuffle_epi8(table, nibbles));
 }
+#endif
 
 /*
-    Convert a hexadecimal string to an unsigned int value
-    length = stores the length, in bits, of the input
+    Decode a row of hex text of any length into a packed row, one bit per cell (set = WALL)
+    Decoding stops at the first non-hex character or once the whole width is covered
+    Return the number of characters decoded
+    hex    = row text, does not need to be null terminated
+    length = number of characters available in hex
+    row    = destination, (width + 63) / 64 words. Cells past the decoded text are FREE
+    width  = number of cells in the row
 */
-unsigned int Hex2Int(char * hex, unsigned int * length)
+size_t DecodeHexRow(const char * hex, size_t length, uint64_t * row, int width)
 {
-    int value   = 0;
-    int i       = 0;
-    (*length)   = 0;
-    while(*hex)
+    size_t digits = ((size_t)width + 3) / 4;
+    size_t words  = ((size_t)width + WORD_BITS - 1) / WORD_BITS;
+    length = (length < digits) ? length : digits;
+
+    size_t count = 0;
+    size_t word  = 0;
+#ifdef __SSSE3__
+    while(length - count >= 16)
     {
-        unsigned char byte = *hex++;
-        if(byte >= '0' && byte <= '9')
+        int decoded = DecodeHexWord(hex + count, &row[word++]);
+        count += decoded;
+        if(decoded < 16)
         {
-            byte = byte - '0';
+            length = count; // Hit a non-hex character
+            break;
         }
-        else if(byte >= 'a' && byte <= 'f')
-        {
-            byte = byte - 'a' + 10;
-        }
-        else if(byte >= 'A' && byte <= 'F')
+    }
+#endif
+    // Remaining characters, less than a full word
+    while(count < length)
+    {
+        uint64_t value = 0;
+        int i = 0;
+        for(; i < 16 && count < length; i++)
         {
-            byte = byte - 'A' + 10;   
+            int nibble = HexValue((unsigned char)hex[count]);
+            if(nibble < 0)
+            {
+                length = count;
+                break;
+            }
+            value |= (uint64_t)REVERSED_NIBBLE[nibble] << (i * 4);
+            count++;
         }
-        else
+        row[word++] = value;
+    }
+    while(word < words)
+    {
+        row[word++] = 0;
+    }
+    if(width % WORD_BITS)
+    {
+        row[words - 1] &= ((uint64_t)1 << (width % WORD_BITS)) - 1;
+    }
+    return count;
+}
+
+/*
+    Encode a packed row into hex text, the inverse of DecodeHexRow
+    hex = destination, at least (width + 3) / 4 characters plus 16 characters of slack. Not null terminated
+    Return the number of characters written
+*/
+size_t EncodeHexRow(const uint64_t * row, int width, char * hex)
+{
+    size_t digits = ((size_t)width + 3) / 4;
+    size_t count  = 0;
+    for(size_t word = 0; count < digits; word++)
+    {
+#ifdef __SSSE3__
+        EncodeHexWord(row[word], hex + count);
+#else
+        for(int i = 0; i < 16; i++)
         {
-            continue;
+            hex[count + i] = HEX_DIGITS[REVERSED_NIBBLE[(row[word] >> (i * 4)) & 0xF]];
         }
-        value = (value << 4) | (byte & 0xF);
-        (*length)++;
+#endif
+        count += 16;
+    }
+    return digits;
+}
+
+// Random generator state of the calling thread
+static THREAD_LOCAL uint64_t randomState = 0x853C49E6748FEA9BULL;
+
+/*
+    Seed the random generator of the calling thread
+    Each thread has its own state, so threads seeded alike produce the same numbers
+*/
+void SeedRandom(uint64_t seed)
+{
+    randomState = seed;
+}
+
+/*
+    Return a random number between 0 and UINT32_MAX from the calling thread's generator (splitmix64)
+    Replaces rand(), whose state is shared by every thread
+*/
+unsigned int Random(void)
+{
+    uint64_t z = (randomState += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (unsigned int)((z ^ (z >> 31)) >> 32);
+}
+
+// Number of maps created so far, the source of unique map revisions
+static uint64_t mapCount = 0;
+
+/*
+    Return the first revision of a new map. The map count goes in the high 32 bits and edits
+    count up the low bits, so no two maps share a revision, even at the same address
+*/
+static uint64_t NewRevision(void)
+{
+    return __atomic_add_fetch(&mapCount, 1, __ATOMIC_RELAXED) << 32;
+}
+
+/*
+    Move the map to a new revision, after an edit
+    Edits through the inline accessors do not do this themselves, call it after writing cells with
+    MapSet/MapSetUnchecked that caches of the map should see. When the low 32 bits run out the map
+    takes a fresh map number instead of carrying into its own, so revisions stay unique
+*/
+void Touch(Map * map)
+{
+    map->revision++;
+    if((uint32_t)map->revision == 0)
+    {
+        map->revision = NewRevision();
     }
-    (*length) *= 4; // 1 Hex char is 4 bits
-    return ReverseBits(value);
 }
 
 /*
@@ -79,57 +252,333 @@ BOOL ResizeArray(void ** ppArray, unsigned int sizeArray, unsigned int sizeType)
     return FALSE;
 }
 
+/*
+    Return the number of cells allocated for a MAP_CELLS map, including the padding of partial tiles/blocks
+*/
+static size_t CellCount(Map * map)
+{
+    if(map->format & MAP_TILED)
+    {
+        return (size_t)map->pitch * ((map->height + TILE_SIZE - 1) / TILE_SIZE) * (TILE_SIZE * TILE_SIZE);
+    }
+    if(map->format & MAP_MORTON)
+    {
+        return (size_t)map->pitch * ((map->height + BLOCK_SIZE - 1) / BLOCK_SIZE) * (BLOCK_SIZE * BLOCK_SIZE);
+    }
+    return (size_t)map->width * map->height;
+}
+
+/*
+    Set the format of the map and derive the row stride and tile pitch from its width
+    Packed maps ignore the layout flags, and MAP_MORTON takes precedence over MAP_TILED
+*/
+static void SetFormat(Map * map, int format)
+{
+    if(format & MAP_PACKED)
+    {
+        format &= ~(MAP_TILED | MAP_MORTON);
+    }
+    if(format & MAP_MORTON)
+    {
+        format &= ~MAP_TILED;
+    }
+    map->format = format;
+    map->stride = (map->width + WORD_BITS - 1) / WORD_BITS;
+    map->pitch  = (format & MAP_TILED)
+        ? (map->width + TILE_SIZE - 1) / TILE_SIZE
+        : (map->width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+}
+
 /*
     2D array access function. Return value of specified cell
     x = column (ie. how much to the right)
     y = row (ie. how far down to go)
 
+    Packed maps only store FREE/WALL, plus PATH if a scratch plane was requested
+    Cells outside the map read as WALL: the rows of a packed map are not padded, so a read just
+    past the first or last row would leave the allocation. Hot loops use MapGetUnchecked instead
+
     https://www.geeksforgeeks.org/pass-2d-array-parameter-c/
     https://dyclassroom.com/c/c-pointers-and-two-dimensional-array
 */
 unsigned int GetCell(Map * map, int x, int y)
 {
-    // height is the offset for accessing 2D array
-    return *((map->data + x * map->height) + y);
+    return MapGet(map, x, y);
 }
 
 /*
-    2D array access function. Set the value of specified cell
+    2D array access function. Set the value of specified cell and move the map to a new revision
     x = column (ie. how much to the right)
     y = row (ie. how far down to go)
 */
 void SetCell(Map * map, int x, int y, unsigned int value)
 {
-    // height is the offset for accessing 2D array
-    *((map->data + x * map->height) + y) = value;
+    MapSetUnchecked(map, x, y, value);
+    Touch(map);
 }
 
 /*
-    Create and return new Map object
+    Return 64 cells of a row as a bitmask, a set bit is a WALL
+    Bit 0 is the leftmost cell of the word. Bits past the map width are always 0
+    row  = row (y coordinate)
+    word = index of the 64-cell word in the row
+*/
+uint64_t GetRowWord(Map * map, int row, int word)
+{
+    if(map->format & MAP_PACKED)
+    {
+        return map->walls[row * map->stride + word];
+    }
+    uint64_t value = 0;
+    int x = word * WORD_BITS;
+    int count = map->width - x;
+    if(count > WORD_BITS)
+    {
+        count = WORD_BITS;
+    }
+    for(int i = 0; i < count; i++)
+    {
+        value |= (uint64_t)(GetCell(map, x + i, row) == WALL) << i;
+    }
+    return value;
+}
+
+/*
+    Set 64 cells of a row from a bitmask, a set bit is a WALL and a clear bit is FREE
+    Bits past the map width are ignored. Moves the map to a new revision once, not once per cell
+    row  = row (y coordinate)
+    word = index of the 64-cell word in the row
+*/
+void SetRowWord(Map * map, int row, int word, uint64_t value)
+{
+    int x = word * WORD_BITS;
+    int count = map->width - x;
+    Touch(map);
+    if(count < WORD_BITS)
+    {
+        value &= ((uint64_t)1 << count) - 1;
+    }
+    else
+    {
+        count = WORD_BITS;
+    }
+    if(map->format & MAP_PACKED)
+    {
+        map->walls[row * map->stride + word] = value;
+        if(map->marks)
+        {
+            map->marks[row * map->stride + word] = 0;
+        }
+        return;
+    }
+    for(int i = 0; i < count; i++)
+    {
+        MapSetUnchecked(map, x + i, row, (value >> i) & 0x1);
+    }
+}
+
+/*
+    Set the cost of entering a cell, creating the cost plane (every cell costing 1) on first use
+    Costs are clamped to 1..MAP_MAX_COST
+    Return FALSE if the cell is outside the map or the plane could not be allocated
+*/
+BOOL SetCost(Map * map, int x, int y, unsigned int cost)
+{
+    if(!MapInBounds(map, x, y))
+    {
+        return FALSE;
+    }
+    if(!map->costs)
+    {
+        map->costs = (uint8_t *)malloc((size_t)map->width * map->height);
+        if(!map->costs)
+        {
+            return FALSE;
+        }
+        memset(map->costs, 1, (size_t)map->width * map->height);
+    }
+    map->costs[(size_t)y * map->width + x] = (uint8_t)__max(__min(cost, MAP_MAX_COST), 1);
+    Touch(map);
+    return TRUE;
+}
+
+/*
+    Create and return new Map object using the given storage format, with its cells allocated from an arena
     Set w and h and set all cells to the specified value
+    The cells are released by resetting the arena, Destroy does not free them
+    If the arena is NULL or too small, the cells are malloc'd and owned by the map instead
+    format = combination of MAP_* flags
+    arena  = arena to allocate from, can be NULL
 */
-void Init(Map * map, int rows, int cols, int value)
+void InitArena(Map * map, int rows, int cols, int value, int format, Arena * arena)
 {
     map->width  = rows;
     map->height = cols;
-    map->data = (unsigned int *)malloc(rows * cols * sizeof(unsigned int));
-    for(int i = 0; i < rows; i++)
+    map->data   = NULL;
+    map->walls  = NULL;
+    map->marks  = NULL;
+    map->costs  = NULL;
+    map->mapping        = NULL;
+    map->mappingSize    = 0;
+    map->arena          = NULL;
+    map->revision       = NewRevision();
+    SetFormat(map, format);
+
+    size_t words = (size_t)map->stride * cols;
+    size_t size  = (format & MAP_PACKED) ? words * sizeof(uint64_t) : CellCount(map) * sizeof(unsigned int);
+    size_t marks = (format & MAP_PACKED) && (format & MAP_SCRATCH) ? words * sizeof(uint64_t) : 0;
+    void * cells = NULL;
+    if(arena)
+    {
+        ArenaMark mark = Arena_namespace.Mark(arena);
+        cells = Arena_namespace.Alloc(arena, size);
+        map->marks = marks ? (uint64_t *)Arena_namespace.Alloc(arena, marks) : NULL;
+        if(!cells || (marks && !map->marks))
+        {
+            Arena_namespace.Reset(arena, mark);
+            cells = NULL;
+            map->marks = NULL;
+        }
+        else
+        {
+            map->arena = arena;
+        }
+    }
+    if(!cells)
+    {
+        cells = malloc(size);
+        map->marks = marks ? (uint64_t *)malloc(marks) : NULL;
+    }
+
+    if(format & MAP_PACKED)
     {
-        for(int ii = 0; ii < cols; ii++)
+        map->walls = (uint64_t *)cells;
+        // Fill word by word, so the padding bits past the width stay clear
+        uint64_t fill = (value == WALL) ? ~(uint64_t)0 : 0;
+        for(int i = 0; i < cols; i++)
         {
-            SetCell(map, i, ii, value);
+            for(int ii = 0; ii < map->stride; ii++)
+            {
+                SetRowWord(map, i, ii, fill); // Also clears the marks
+            }
         }
+        return;
+    }
+    // Fill in storage order, including the padding of partial tiles
+    size_t count = CellCount(map);
+    map->data = (unsigned int *)cells;
+    for(size_t i = 0; i < count; i++)
+    {
+        map->data[i] = value;
+    }
+}
+
+/*
+    Create and return new Map object using the given storage format
+    Set w and h and set all cells to the specified value
+    format = combination of MAP_* flags
+*/
+void InitFormat(Map * map, int rows, int cols, int value, int format)
+{
+    InitArena(map, rows, cols, value, format, NULL);
+}
+
+/*
+    Create and return new Map object
+    Set w and h and set all cells to the specified value
+*/
+void Init(Map * map, int rows, int cols, int value)
+{
+    InitFormat(map, rows, cols, value, MAP_CELLS);
+}
+
+/*
+    Map a whole file into memory, copy-on-write, so cells can be modified without touching the file
+    Return pointer to the mapping, or NULL on failure
+    size = stores the size of the mapping in bytes
+*/
+static void * MapFile(char * filename, size_t * size)
+{
+#ifdef _WIN32
+    // No mmap, read the file into memory instead
+    FILE * file;
+    if((file = fopen(filename, "rb")) == NULL)
+    {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    (*size) = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    void * memory = malloc(*size);
+    if(memory && fread(memory, 1, *size, file) != *size)
+    {
+        free(memory);
+        memory = NULL;
+    }
+    fclose(file);
+    return memory;
+#else
+    int fd = open(filename, O_RDONLY);
+    if(fd < 0)
+    {
+        return NULL;
     }
+    struct stat info;
+    if(fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        close(fd);
+        return NULL;
+    }
+    (*size) = (size_t)info.st_size;
+    void * memory = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd); // Mapping stays valid after the descriptor is closed
+    return (memory == MAP_FAILED) ? NULL : memory;
+#endif
+}
+
+/*
+    Release a mapping created by MapFile
+*/
+static void UnmapFile(void * memory, size_t size)
+{
+#ifdef _WIN32
+    (void)size;
+    free(memory);
+#else
+    munmap(memory, size);
+#endif
 }
 
 /*
-    "Destroy" map, setting all values to 0 and freeing the array
+    "Destroy" map, setting all values to 0 and freeing (or unmapping) the array
 */
 void Destroy(Map * map)
 {
     map->width  = 0;
     map->height = 0;
-    free(map->data);
+    if(map->arena)
+    {
+        // Cell data is released with the arena
+    }
+    else if(map->mapping)
+    {
+        // Cell data lives in the file mapping
+        UnmapFile(map->mapping, map->mappingSize);
+        free(map->marks);
+    }
+    else
+    {
+        free(map->data);
+        free(map->walls);
+        free(map->marks);
+    }
+    free(map->costs);
+    map->arena = NULL;
+    map->data  = NULL;
+    map->walls = NULL;
+    map->marks = NULL;
+    map->costs = NULL;
+    map->mapping = NULL;
 }
 
 /*
@@ -148,11 +597,11 @@ BOOL GenerateStartEndPoints(Map * map)
         {
             return FALSE;
         }
-        map->start  = (unsigned int)(rand() % (max + 1 - min) + min);
-        map->end    = (unsigned int)(rand() % (max + 1 - min) + min);
-    } while( GetCell(map, map->start, min) || GetCell(map, map->end, max) );
+        map->start  = (unsigned int)(Random() % (max + 1 - min) + min);
+        map->end    = (unsigned int)(Random() % (max + 1 - min) + min);
+    } while( GetCell(map, map->start, 1) || GetCell(map, map->end, map->height - 2) ); // Rows next to the edges
     SetCell(map, map->start, 0, 0);
-    SetCell(map, map->end, map->width - 1, 0);
+    SetCell(map, map->end, map->height - 1, 0);
 
     return TRUE;
 }
@@ -163,6 +612,11 @@ BOOL GenerateStartEndPoints(Map * map)
 */
 void AddRowData(Map * map, unsigned long data, int row)
 {
+    if(map->format & MAP_PACKED)
+    {
+        SetRowWord(map, row, 0, data);
+        return;
+    }
     for(int i = 0; i < map->width; i++)
     {
         SetCell(map, i, row, (data & 0x01));
@@ -171,9 +625,179 @@ void AddRowData(Map * map, unsigned long data, int row)
 }
 
 /*
-    Load map from file and extract the data into the map array
+    Return the size, in bytes, of the cell data of the map
 */
-BOOL LoadMap(Map * map, char * filename)
+static size_t MapDataSize(Map * map)
+{
+    if(map->format & MAP_PACKED)
+    {
+        return (size_t)map->stride * map->height * sizeof(uint64_t);
+    }
+    return CellCount(map) * sizeof(unsigned int);
+}
+
+/*
+    Load a binary map file. The cell data is not parsed, the map points straight into the file mapping
+    If the stored format differs from the requested one, the cells are copied into a new map instead
+    format = combination of MAP_* flags
+*/
+BOOL LoadMapBinary(Map * map, char * filename, int format)
+{
+    size_t size = 0;
+    char * memory = (char *)MapFile(filename, &size);
+    if(!memory)
+    {
+        fprintf(stderr, "openerror for file, errno = %d\n", errno);
+        return FALSE;
+    }
+
+    MapHeader * header = (MapHeader *)memory;
+    if(size < sizeof(MapHeader)
+    || memcmp(header->magic, MAP_BINARY_MAGIC, 4) != 0
+    || header->version != MAP_BINARY_VERSION
+    || header->dataOffset % MAP_BINARY_ALIGN != 0
+    || header->dataOffset + header->dataSize > size)
+    {
+        fprintf(stderr, "invalid binary map %s\n", filename);
+        UnmapFile(memory, size);
+        return FALSE;
+    }
+
+    map->width          = header->width;
+    map->height         = header->height;
+    map->start          = header->start;
+    map->end            = header->end;
+    map->data           = NULL;
+    map->walls          = NULL;
+    map->marks          = NULL;
+    map->costs          = NULL;
+    map->mapping        = memory;
+    map->mappingSize    = size;
+    map->arena          = NULL;
+    map->revision       = NewRevision();
+    SetFormat(map, header->format & MAP_STORED);
+    if(MapDataSize(map) != header->dataSize)
+    {
+        fprintf(stderr, "invalid binary map %s\n", filename);
+        Destroy(map);
+        return FALSE;
+    }
+    if(map->format & MAP_PACKED)
+    {
+        map->walls = (uint64_t *)(memory + header->dataOffset);
+    }
+    else
+    {
+        map->data = (unsigned int *)(memory + header->dataOffset);
+    }
+
+    // Stored format or layout does not match, convert row by row
+    Map requested;
+    requested.width = map->width;
+    SetFormat(&requested, format);
+    if((requested.format & MAP_STORED) != map->format)
+    {
+        Map converted;
+        InitFormat(&converted, map->width, map->height, FREE, format);
+        for(int i = 0; i < map->height; i++)
+        {
+            for(int ii = 0; ii < map->stride; ii++)
+            {
+                SetRowWord(&converted, i, ii, GetRowWord(map, i, ii));
+            }
+        }
+        converted.start = map->start;
+        converted.end   = map->end;
+        Destroy(map);
+        (*map) = converted;
+    }
+    else if((format & MAP_PACKED) && (format & MAP_SCRATCH))
+    {
+        map->format |= MAP_SCRATCH;
+        map->marks   = (uint64_t *)calloc((size_t)map->stride * map->height, sizeof(uint64_t));
+    }
+    return (map->width > 0 && map->height > 0);
+}
+
+/*
+    Save map to a binary file, including the start and end points
+    Any solver marks are saved along with the cells of MAP_CELLS maps. The cost plane is not saved,
+    use the text format for weighted maps
+*/
+BOOL SaveMapBinary(Map * map, char * filename)
+{
+    FILE * file;
+    if((file = fopen(filename, "wb")) == NULL)
+    {
+        fprintf(stderr, "openerror for file, errno = %d\n", errno);
+        return FALSE;
+    }
+
+    MapHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAP_BINARY_MAGIC, 4);
+    header.version      = MAP_BINARY_VERSION;
+    header.format       = map->format & MAP_STORED;
+    header.width        = map->width;
+    header.height       = map->height;
+    header.start        = map->start;
+    header.end          = map->end;
+    header.dataOffset   = (sizeof(header) + MAP_BINARY_ALIGN - 1) / MAP_BINARY_ALIGN * MAP_BINARY_ALIGN;
+    header.dataSize     = MapDataSize(map);
+
+    char padding[MAP_BINARY_ALIGN] = {0};
+    void * data = (map->format & MAP_PACKED) ? (void *)map->walls : (void *)map->data;
+    BOOL success = fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(padding, 1, header.dataOffset - sizeof(header), file) == header.dataOffset - sizeof(header)
+        && fwrite(data, 1, header.dataSize, file) == header.dataSize;
+    fclose(file);
+    return success;
+}
+
+/*
+    Read the optional cost section of a text map, starting at the line after the last row
+    Missing digits leave a cell at cost 1, an absent section leaves the map without a cost plane
+    Return FALSE if the cost plane could not be allocated
+*/
+static BOOL LoadCosts(Map * map, const char * line, const char * end)
+{
+    size_t headerLength = strlen(MAP_COSTS_HEADER);
+    if((size_t)(end - line) < headerLength || memcmp(line, MAP_COSTS_HEADER, headerLength) != 0)
+    {
+        return TRUE;
+    }
+    map->costs = (uint8_t *)malloc((size_t)map->width * map->height);
+    if(!map->costs)
+    {
+        return FALSE;
+    }
+    memset(map->costs, 1, (size_t)map->width * map->height);
+    line = memchr(line, '\n', end - line);
+    for(int y = 0; y < map->height && line && ++line < end; y++)
+    {
+        uint8_t * row = &map->costs[(size_t)y * map->width];
+        for(int x = 0; x < map->width && line + 2 * x + 1 < end; x++)
+        {
+            int high = HexValue(line[2 * x]);
+            int low = HexValue(line[2 * x + 1]);
+            if(high < 0 || low < 0)
+            {
+                break;
+            }
+            row[x] = (uint8_t)__max((high << 4) | low, 1);
+        }
+        line = memchr(line, '\n', end - line);
+    }
+    return TRUE;
+}
+
+/*
+    Load map from file into a map using the given storage format, with its cells allocated from an arena
+    Accepts both the hex text format and the binary format. Binary maps are mapped, not allocated
+    format = combination of MAP_* flags
+    arena  = arena to allocate from, can be NULL
+*/
+BOOL LoadMapArena(Map * map, char * filename, int format, Arena * arena)
 {
     int rows = 0;
     int cols = 0;
@@ -184,24 +808,102 @@ BOOL LoadMap(Map * map, char * filename)
         return FALSE;
     }
 
-    fscanf(file, "%d, %d\n", &rows, &cols);
-    Init(map, rows, cols, FREE);
+    // Binary maps are recognised by their magic number
+    char magic[4] = {0};
+    if(fread(magic, 1, 4, file) == 4 && memcmp(magic, MAP_BINARY_MAGIC, 4) == 0)
+    {
+        fclose(file);
+        return LoadMapBinary(map, filename, format);
+    }
+    fclose(file);
+
+    // Map the whole text file and decode the rows in place
+    size_t size = 0;
+    char * text = (char *)MapFile(filename, &size);
+    if(!text)
+    {
+        fprintf(stderr, "openerror for file, errno = %d\n", errno);
+        return FALSE;
+    }
+    char * end = text + size;
+    char * line = memchr(text, '\n', size);
+    if(!line)
+    {
+        UnmapFile(text, size);
+        return FALSE;
+    }
+
+    char str[128] = {0};
+    size_t headerLength = (size_t)(line - text);
+    memcpy(str, text, (headerLength < sizeof(str)) ? headerLength : sizeof(str) - 1);
+    sscanf(str, "%d, %d", &rows, &cols);
+    InitArena(map, rows, cols, FREE, format, arena);
 
-    char str[128];
+    // Packed rows are decoded straight into the map, cells go through a row buffer
+    ArenaMark mark = arena ? Arena_namespace.Mark(arena) : 0;
+    uint64_t * buffer = NULL;
+    BOOL scratch = FALSE; // Row buffer came from the arena
+    if(!(format & MAP_PACKED))
+    {
+        size_t size = map->stride * sizeof(uint64_t);
+        buffer = map->arena ? (uint64_t *)Arena_namespace.Alloc(arena, size) : NULL;
+        scratch = (buffer != NULL);
+        buffer = scratch ? buffer : (uint64_t *)malloc(size);
+    }
     int row = 0;
-    while(fgets(str, 128, file) != NULL)
+    while(row < map->height && ++line < end)
+    {
+        uint64_t * words = buffer ? buffer : map->walls + (size_t)row * map->stride;
+        size_t count = DecodeHexRow(line, end - line, words, map->width);
+        if(buffer)
+        {
+            for(int i = 0; i < map->stride; i++)
+            {
+                SetRowWord(map, row, i, buffer[i]);
+            }
+        }
+        row++;
+        line = memchr(line + count, '\n', end - line - count);
+        if(!line)
+        {
+            break;
+        }
+    }
+    BOOL costs = !line || ++line >= end || LoadCosts(map, line, end);
+    if(scratch)
     {
-        unsigned int l = 0;
-        unsigned int data = Hex2Int(str, &l);
-        AddRowData(map, data, row++);
+        Arena_namespace.Reset(arena, mark);
     }
+    else
+    {
+        free(buffer);
+    }
+    UnmapFile(text, size);
     GenerateStartEndPoints(map);
-    fclose(file);
-    return (map->width | map->height > 0);
+    return costs && map->width > 0 && map->height > 0;
+}
+
+/*
+    Load map from file into a map using the given storage format
+    Accepts both the hex text format and the binary format
+    format = combination of MAP_* flags
+*/
+BOOL LoadMapFormat(Map * map, char * filename, int format)
+{
+    return LoadMapArena(map, filename, format, NULL);
+}
+
+/*
+    Load map from file and extract the data into the map array
+*/
+BOOL LoadMap(Map * map, char * filename)
+{
+    return LoadMapFormat(map, filename, MAP_CELLS);
 }
 
 /*
     Save map to file
+    The cost plane, if the map has one, follows the rows
 */
 BOOL SaveMap(Map * map, char * filename)
 {
@@ -212,29 +914,66 @@ BOOL SaveMap(Map * map, char * filename)
         return FALSE;
     }
     fprintf(file, "%d, %d\n", map->width, map->height); // Write width + height
+
+    // One row at a time: gather the row words, encode, write
+    uint64_t * words = (uint64_t *)malloc(map->stride * sizeof(uint64_t));
+    char * str = (char *)malloc(map->stride * 16 + 1);
     for(int i = 0; i < map->height; i++)
     {
-        unsigned long row = 0;
-        for(int ii = 0; ii < map->width; ii++)
+        for(int ii = 0; ii < map->stride; ii++)
         {
-            char value = (char)Map_namespace.GetCell(map, ii, i);
-            row = (row << 1) | (value & 0x1);
+            words[ii] = GetRowWord(map, i, ii);
         }
-        fprintf(file, "%x\n", row);
+        size_t length = EncodeHexRow(words, map->width, str);
+        str[length++] = '\n';
+        fwrite(str, 1, length, file);
     }
-    fclose(file);
-    return TRUE;
+
+    // Cost rows, two hex digits per cell
+    char * costs = map->costs ? (char *)malloc((size_t)map->width * 2 + 1) : NULL;
+    if(costs)
+    {
+        static const char digits[] = "0123456789abcdef";
+        fprintf(file, "%s\n", MAP_COSTS_HEADER);
+        for(int i = 0; i < map->height; i++)
+        {
+            const uint8_t * row = &map->costs[(size_t)i * map->width];
+            for(int ii = 0; ii < map->width; ii++)
+            {
+                costs[2 * ii]       = digits[row[ii] >> 4];
+                costs[2 * ii + 1]   = digits[row[ii] & 0xF];
+            }
+            costs[2 * map->width] = '\n';
+            fwrite(costs, 1, (size_t)map->width * 2 + 1, file);
+        }
+        free(costs);
+    }
+    free(words);
+    free(str);
+    BOOL success = !map->costs || costs;
+    success = (fclose(file) == 0) && success;
+    return success;
 }
 
 // Map namespace struct, contains function pointers related to the Map struct
 const struct map_namespace Map_namespace = 
 {
     .Init = Init,
+    .InitFormat = InitFormat,
+    .InitArena = InitArena,
     .Destroy = Destroy,
     .GenerateStartEndPoints = GenerateStartEndPoints,
     .AddRowData = AddRowData,
     .LoadMap = LoadMap,
+    .LoadMapFormat = LoadMapFormat,
+    .LoadMapArena = LoadMapArena,
     .SaveMap = SaveMap,
+    .LoadMapBinary = LoadMapBinary,
+    .SaveMapBinary = SaveMapBinary,
     .GetCell = GetCell,
-    .SetCell = SetCell
+    .SetCell = SetCell,
+    .GetRowWord = GetRowWord,
+    .SetRowWord = SetRowWord,
+    .SetCost = SetCost,
+    .Touch = Touch
 };
\ No newline at end of file
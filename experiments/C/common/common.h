@@ -1,41 +1,341 @@
 #ifndef COMMON_H
 #define COMMON_H
 
+#include <stdint.h>
+#include <stddef.h>
+
 #define INT_BITS (sizeof(int) * 8)
+#define WORD_BITS 64
 
 typedef char BOOL;
 #define TRUE 1
 #define FALSE 0
 
+// MSVC provides __min/__max, other compilers do not
+#ifndef __min
+#define __min(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+#ifndef __max
+#define __max(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
 #define FREE 0
 #define WALL 1
 #define PATH 2
 
-unsigned int ReverseBits(unsigned int value);
-unsigned int Hex2Int(char * hex, unsigned int * length);
+// Map storage formats, chosen when the map is created
+#define MAP_CELLS   0x0 // One unsigned int per cell (default)
+#define MAP_PACKED  0x1 // One bit per cell, rows packed into 64-bit words
+#define MAP_SCRATCH 0x2 // Packed maps only: allocate an extra bitplane for solver marks
+
+// Cell layouts of MAP_CELLS maps, chosen when the map is created (packed maps are always row-major)
+// The default layout is column-major. Blocked layouts keep N/S/E/W and diagonal neighbours close together
+#define MAP_TILED   0x10 // 8x8 cell tiles, row-major inside and across tiles
+#define MAP_MORTON  0x20 // Z-order inside 64x64 cell blocks, blocks row-major
+#define MAP_STORED  (MAP_PACKED | MAP_TILED | MAP_MORTON) // Flags that describe the stored data
+
+#define TILE_SIZE   8
+#define BLOCK_SIZE  64
+
+// Binary map file format. The cell data is stored exactly as it is laid out in memory,
+// so a loaded map points straight into the file mapping
+#define MAP_BINARY_MAGIC    "MAZE"
+#define MAP_BINARY_VERSION  1
+#define MAP_BINARY_ALIGN    64  // Alignment of the cell data inside the file, in bytes
+
+// Text maps may follow their rows with this line and one row of cell costs per map row,
+// two hex digits per cell. Readers that stop after the rows still load the walls
+#define MAP_COSTS_HEADER    "costs"
+#define MAP_MAX_COST        255
+
+// Thread-local storage, so every thread gets its own random generator state
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
+void SeedRandom(uint64_t seed);
+unsigned int Random(void);
+size_t DecodeHexRow(const char * hex, size_t length, uint64_t * row, int width);
+size_t EncodeHexRow(const uint64_t * row, int width, char * hex);
 BOOL ResizeArray(void ** ppArray, unsigned int sizeArray, unsigned int sizeType);
 
+struct Arena;
+
+/*
+    Header at the start of a binary map file (native byte order)
+    Cell data starts at dataOffset: one unsigned int per cell for MAP_CELLS, in the stored layout
+    (column-major unless MAP_TILED/MAP_MORTON is set), or rows of 64-bit words for MAP_PACKED
+*/
+typedef struct MapHeader
+{
+    char     magic[4];      // MAP_BINARY_MAGIC
+    uint32_t version;       // MAP_BINARY_VERSION
+    uint32_t format;        // MAP_STORED flags of the stored data
+    int32_t  width;
+    int32_t  height;
+    int32_t  start;
+    int32_t  end;
+    uint32_t reserved;
+    uint64_t dataOffset;    // Offset of the cell data from the start of the file
+    uint64_t dataSize;      // Size of the cell data in bytes
+} MapHeader;
+
 typedef struct Map
 {
     int width;
     int height;
     int start;  // Starting x coordinate in the first row
     int end;    // End x coordinate in the last row
-    unsigned int * data;
+    int format; // MAP_* flags the map was created with
+    int stride; // Number of 64-bit words per row of a packed map
+    int pitch;  // Number of tiles (MAP_TILED) or blocks (MAP_MORTON) per row
+    unsigned int * data;    // MAP_CELLS storage
+    uint64_t * walls;       // MAP_PACKED storage, a set bit is a WALL
+    uint64_t * marks;       // MAP_SCRATCH storage, a set bit is a PATH (or any other solver mark)
+    uint8_t * costs;        // Cost of entering every cell, row-major, 1 to MAP_MAX_COST. NULL when every cell costs 1.
+                            // Always malloc'd and owned by the map, only the weighted solver reads it
+    void * mapping;         // File mapping the cell data points into, if loaded from a binary map
+    size_t mappingSize;
+    struct Arena * arena;   // Arena the cells were allocated from, NULL if they are owned by the map
+    uint64_t revision;      // Unique to this map and changed by every SetCell/SetRowWord, for caches of derived data.
+                            // Writes through the inline accessors (solver marks) do not change it, Touch does
 } Map;
 
 typedef struct map_namespace
-{    
+{
     void (* Init)(Map * map, int rows, int cols, int value);
+    void (* InitFormat)(Map * map, int rows, int cols, int value, int format);
+    void (* InitArena)(Map * map, int rows, int cols, int value, int format, struct Arena * arena);
     void (* Destroy)(Map * map);
     BOOL (* GenerateStartEndPoints)(Map * map);
     void (* AddRowData)(Map * map, unsigned long data, int row);
     BOOL (* LoadMap)(Map * map, char * filename);
+    BOOL (* LoadMapFormat)(Map * map, char * filename, int format);
+    BOOL (* LoadMapArena)(Map * map, char * filename, int format, struct Arena * arena);
     BOOL (* SaveMap)(Map * map, char * filename);
+    BOOL (* LoadMapBinary)(Map * map, char * filename, int format);
+    BOOL (* SaveMapBinary)(Map * map, char * filename);
     unsigned int (* GetCell)(Map * map, int x, int y);
     void (* SetCell)(Map * map, int x, int y, unsigned int value);
+    uint64_t (* GetRowWord)(Map * map, int row, int word);
+    void (* SetRowWord)(Map * map, int row, int word, uint64_t value);
+    BOOL (* SetCost)(Map * map, int x, int y, unsigned int cost);
+    void (* Touch)(Map * map);
 } map_namespace;
 
 extern const struct map_namespace Map_namespace;
 
+/*
+    Header-only accessors. Unlike the Map_namespace function pointers these can be inlined
+    into hot loops. The Unchecked variants do no bounds checks, the checked variants treat
+    everything outside the map as WALL
+*/
+
+// Neighbour bits returned by the neighbour queries
+enum Directions
+{
+    cNorth = 1,
+    cSouth = 2,
+    cEast  = 4,
+    cWest  = 8
+};
+
+/*
+    View of a row or column of a MAP_CELLS map: element i is data[i * step]
+    Only available for the default column-major layout, other formats return an empty span
+*/
+typedef struct MapSpan
+{
+    unsigned int * data;
+    ptrdiff_t step;
+    int length;
+} MapSpan;
+
+/*
+    Spread the low 16 bits of a value to the even bit positions, for Morton (Z-order) indexing
+*/
+static inline unsigned int MapSpreadBits(unsigned int value)
+{
+    value = (value | (value << 8)) & 0x00FF00FF;
+    value = (value | (value << 4)) & 0x0F0F0F0F;
+    value = (value | (value << 2)) & 0x33333333;
+    value = (value | (value << 1)) & 0x55555555;
+    return value;
+}
+
+/*
+    Return the index of a cell in the data array of a MAP_CELLS map, according to its layout
+    x = column (ie. how much to the right)
+    y = row (ie. how far down to go)
+*/
+static inline size_t MapCellIndex(const Map * map, int x, int y)
+{
+    if(map->format & MAP_TILED)
+    {
+        size_t tile = (size_t)(y / TILE_SIZE) * map->pitch + (x / TILE_SIZE);
+        return tile * (TILE_SIZE * TILE_SIZE) + (y % TILE_SIZE) * TILE_SIZE + (x % TILE_SIZE);
+    }
+    if(map->format & MAP_MORTON)
+    {
+        size_t block = (size_t)(y / BLOCK_SIZE) * map->pitch + (x / BLOCK_SIZE);
+        return block * (BLOCK_SIZE * BLOCK_SIZE) + (MapSpreadBits(x % BLOCK_SIZE) | (MapSpreadBits(y % BLOCK_SIZE) << 1));
+    }
+    // height is the offset for accessing 2D array
+    return (size_t)x * map->height + y;
+}
+
+/*
+    Return TRUE if the coordinates are inside the map
+*/
+static inline BOOL MapInBounds(const Map * map, int x, int y)
+{
+    return (unsigned int)x < (unsigned int)map->width && (unsigned int)y < (unsigned int)map->height;
+}
+
+/*
+    Return value of specified cell, without bounds checks
+*/
+static inline unsigned int MapGetUnchecked(const Map * map, int x, int y)
+{
+    if(map->format & MAP_PACKED)
+    {
+        size_t index = (size_t)y * map->stride + (x / WORD_BITS);
+        uint64_t bit = (uint64_t)1 << (x % WORD_BITS);
+        if(map->marks && (map->marks[index] & bit))
+        {
+            return PATH;
+        }
+        return (map->walls[index] & bit) ? WALL : FREE;
+    }
+    return map->data[MapCellIndex(map, x, y)];
+}
+
+/*
+    Set the value of specified cell, without bounds checks
+    On packed maps any value other than FREE or WALL is collapsed into a single mark bit,
+    which is dropped if the map has no scratch plane
+*/
+static inline void MapSetUnchecked(Map * map, int x, int y, unsigned int value)
+{
+    if(map->format & MAP_PACKED)
+    {
+        size_t index = (size_t)y * map->stride + (x / WORD_BITS);
+        uint64_t bit = (uint64_t)1 << (x % WORD_BITS);
+        map->walls[index] = (value == WALL) ? (map->walls[index] | bit) : (map->walls[index] & ~bit);
+        if(map->marks)
+        {
+            BOOL mark = (value != WALL && value != FREE);
+            map->marks[index] = mark ? (map->marks[index] | bit) : (map->marks[index] & ~bit);
+        }
+        return;
+    }
+    map->data[MapCellIndex(map, x, y)] = value;
+}
+
+/*
+    Return the cost of entering a cell, 1 on maps without a cost plane. Walls keep their cost,
+    they are never entered
+*/
+static inline unsigned int MapCost(const Map * map, int x, int y)
+{
+    return map->costs ? map->costs[(size_t)y * map->width + x] : 1;
+}
+
+/*
+    Return value of specified cell, or WALL if it is outside the map
+*/
+static inline unsigned int MapGet(const Map * map, int x, int y)
+{
+    return MapInBounds(map, x, y) ? MapGetUnchecked(map, x, y) : WALL;
+}
+
+/*
+    Set the value of specified cell. Cells outside the map are ignored
+    Return FALSE if the cell was outside the map
+*/
+static inline BOOL MapSet(Map * map, int x, int y, unsigned int value)
+{
+    if(!MapInBounds(map, x, y))
+    {
+        return FALSE;
+    }
+    MapSetUnchecked(map, x, y, value);
+    return TRUE;
+}
+
+/*
+    Return a view of a row (y coordinate) of a column-major MAP_CELLS map
+*/
+static inline MapSpan MapRow(Map * map, int y)
+{
+    MapSpan span = {NULL, 0, 0};
+    if(!(map->format & MAP_STORED) && (unsigned int)y < (unsigned int)map->height)
+    {
+        span.data   = map->data + y;
+        span.step   = map->height;
+        span.length = map->width;
+    }
+    return span;
+}
+
+/*
+    Return a view of a column (x coordinate) of a column-major MAP_CELLS map
+*/
+static inline MapSpan MapColumn(Map * map, int x)
+{
+    MapSpan span = {NULL, 0, 0};
+    if(!(map->format & MAP_STORED) && (unsigned int)x < (unsigned int)map->width)
+    {
+        span.data   = map->data + (size_t)x * map->height;
+        span.step   = 1;
+        span.length = map->height;
+    }
+    return span;
+}
+
+/*
+    Return element i of a span, without bounds checks
+*/
+static inline unsigned int MapSpanGet(MapSpan span, int i)
+{
+    return span.data[i * span.step];
+}
+
+/*
+    Return the neighbours (cNorth | cSouth | cEast | cWest) whose cell holds the given value
+    Neighbours outside the map never match
+*/
+static inline int MapNeighbourMask(const Map * map, int x, int y, unsigned int value)
+{
+    int mask = 0;
+    mask |= (y > 0 && MapGetUnchecked(map, x, y - 1) == value) ? cNorth : 0;
+    mask |= (y + 1 < map->height && MapGetUnchecked(map, x, y + 1) == value) ? cSouth : 0;
+    mask |= (x + 1 < map->width && MapGetUnchecked(map, x + 1, y) == value) ? cEast : 0;
+    mask |= (x > 0 && MapGetUnchecked(map, x - 1, y) == value) ? cWest : 0;
+    return mask;
+}
+
+/*
+    Return the neighbours that are FREE, in one call
+*/
+static inline int MapFreeNeighbours(const Map * map, int x, int y)
+{
+    return MapNeighbourMask(map, x, y, FREE);
+}
+
+/*
+    Return the neighbours that are WALL, counting the outside of the map as wall
+*/
+static inline int MapWallNeighbours(const Map * map, int x, int y)
+{
+    int mask = 0;
+    mask |= (MapGet(map, x, y - 1) == WALL) ? cNorth : 0;
+    mask |= (MapGet(map, x, y + 1) == WALL) ? cSouth : 0;
+    mask |= (MapGet(map, x + 1, y) == WALL) ? cEast : 0;
+    mask |= (MapGet(map, x - 1, y) == WALL) ? cWest : 0;
+    return mask;
+}
+
 #endif // COMMON_H
\ No newline at end of file
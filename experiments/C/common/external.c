@@ -0,0 +1,436 @@
+#define _FILE_OFFSET_BITS 64
+
+#include "external.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#define DISTANCE_NONE UINT32_MAX
+
+/*
+    A horizontal band of a packed binary map and its distances, with one halo row above and below
+    Only one band is in memory at a time, the distance of every cell lives in the scratch file
+    Buffer row 0 is the halo row above the band, rows 1 to loaded the band, loaded + 1 the halo row below
+*/
+typedef struct Band
+{
+    FILE * map;
+    FILE * distances;       // Scratch file, one uint32_t per cell, row-major
+    int64_t dataOffset;     // Offset of the cell data in the map file
+    int width;
+    int height;
+    int stride;             // 64-bit words per row
+    int rows;               // Map rows per band
+    int count;              // Number of bands
+    int first;              // First map row of the loaded band
+    int loaded;             // Rows of the loaded band, the last band can have fewer than rows
+    uint64_t * walls;       // rows + 2 rows of wall bits, halo rows outside the map are all WALL
+    uint32_t * distance;    // rows + 2 rows of distances from the start, DISTANCE_NONE when not reached
+    uint32_t * fifo;        // Band cells in the order they are expanded
+    uint64_t * seeds;       // Distance << 32 | cell, band cells improved from the halo rows or the start
+} Band;
+
+/*
+    Move to a byte offset of a file, which can be past 2GB
+*/
+static BOOL Seek(FILE * file, int64_t offset)
+{
+#ifdef _WIN32
+    return _fseeki64(file, offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+static BOOL ReadAt(FILE * file, int64_t offset, void * buffer, size_t size)
+{
+    return Seek(file, offset) && fread(buffer, 1, size, file) == size;
+}
+
+static BOOL WriteAt(FILE * file, int64_t offset, const void * buffer, size_t size)
+{
+    return Seek(file, offset) && fwrite(buffer, 1, size, file) == size;
+}
+
+/*
+    Return TRUE if a cell of a buffer row is not a WALL
+*/
+static inline BOOL Open(const Band * band, int row, int x)
+{
+    return !((band->walls[(size_t)row * band->stride + x / WORD_BITS] >> (x % WORD_BITS)) & 1);
+}
+
+/*
+    Read a band and its halo rows from the map and the scratch file
+    index = band to read
+    walls = also read the wall bits, the walk back only needs the distances
+*/
+static BOOL LoadBand(Band * band, int index, BOOL walls)
+{
+    band->first = index * band->rows;
+    band->loaded = __min(band->rows, band->height - band->first);
+    int from = __max(band->first - 1, 0);
+    int to = __min(band->first + band->loaded, band->height - 1);
+    size_t offset = (size_t)(from - band->first + 1);   // Buffer row of map row from
+    size_t rows = (size_t)(to - from + 1);
+    size_t bufferRows = (size_t)band->loaded + 2;
+
+    // Halo rows outside the map are walls that were never reached
+    for(size_t i = 0; i < (size_t)band->width; i++)
+    {
+        band->distance[i] = DISTANCE_NONE;
+        band->distance[(bufferRows - 1) * band->width + i] = DISTANCE_NONE;
+    }
+    BOOL success = ReadAt(band->distances, (int64_t)from * band->width * sizeof(uint32_t),
+        band->distance + offset * band->width, rows * band->width * sizeof(uint32_t));
+    if(success && walls)
+    {
+        for(size_t i = 0; i < (size_t)band->stride; i++)
+        {
+            band->walls[i] = ~(uint64_t)0;
+            band->walls[(bufferRows - 1) * band->stride + i] = ~(uint64_t)0;
+        }
+        success = ReadAt(band->map, band->dataOffset + (int64_t)from * band->stride * sizeof(uint64_t),
+            band->walls + offset * band->stride, rows * band->stride * sizeof(uint64_t));
+    }
+    return success;
+}
+
+/*
+    Write the distances of the loaded band back to the scratch file, without its halo rows
+*/
+static BOOL StoreBand(Band * band)
+{
+    return WriteAt(band->distances, (int64_t)band->first * band->width * sizeof(uint32_t),
+        band->distance + band->width, (size_t)band->loaded * band->width * sizeof(uint32_t));
+}
+
+/*
+    Fill the scratch file with DISTANCE_NONE, a band at a time
+*/
+static BOOL ClearDistances(Band * band)
+{
+    memset(band->distance, 0xFF, (size_t)band->rows * band->width * sizeof(uint32_t));
+    BOOL success = TRUE;
+    for(int y = 0; y < band->height && success; y += band->rows)
+    {
+        int rows = __min(band->rows, band->height - y);
+        success = WriteAt(band->distances, (int64_t)y * band->width * sizeof(uint32_t),
+            band->distance, (size_t)rows * band->width * sizeof(uint32_t));
+    }
+    return success;
+}
+
+/*
+    Lower the distance of a band cell, and note when it can lower a cell of the halo rows in turn:
+    the neighbouring band has to be searched again
+    cell = cell of the band, row-major from the first row of the band
+*/
+static inline void Improve(Band * band, uint32_t cell, uint32_t distance, BOOL * up, BOOL * down)
+{
+    int x = cell % band->width;
+    int row = cell / band->width + 1;
+    band->distance[(size_t)band->width + cell] = distance;
+    if(row == 1 && Open(band, 0, x) && distance + 1 < band->distance[x])
+    {
+        (*up) = TRUE;
+    }
+    if(row == band->loaded && Open(band, row + 1, x) && distance + 1 < band->distance[(size_t)(row + 1) * band->width + x])
+    {
+        (*down) = TRUE;
+    }
+}
+
+static int CompareSeeds(const void * a, const void * b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/*
+    Breadth first search of the loaded band from the cells that the halo rows (or the start point)
+    bring closer to the start. The seeds are sorted by distance and merged with the FIFO, so cells
+    are expanded in order of distance and every cell is queued at most once
+    start    = x of the start point, searched from when the band holds the first row
+    up, down = set to TRUE when the band above or below has to be searched again
+    Return TRUE if any distance of the band changed
+*/
+static BOOL Relax(Band * band, int start, BOOL * up, BOOL * down, size_t * expanded)
+{
+    static const int offsets[4][2] = {{0, -1}, {0, 1}, {1, 0}, {-1, 0}};
+    int width = band->width;
+    uint32_t * distance = band->distance + width; // Row 0 is the first row of the band
+    const uint32_t * above = band->distance;
+    const uint32_t * below = distance + (size_t)band->loaded * width;
+    uint32_t last = (uint32_t)(band->loaded - 1) * width;
+    size_t seedCount = 0;
+    if(band->first == 0 && Open(band, 1, start) && distance[start] != 0)
+    {
+        band->seeds[seedCount++] = (uint32_t)start;
+    }
+    for(int x = 0; x < width; x++)
+    {
+        if(above[x] != DISTANCE_NONE && Open(band, 1, x) && above[x] + 1 < distance[x])
+        {
+            band->seeds[seedCount++] = ((uint64_t)(above[x] + 1) << 32) | (uint32_t)x;
+        }
+        if(below[x] != DISTANCE_NONE && Open(band, band->loaded, x) && below[x] + 1 < distance[last + x])
+        {
+            band->seeds[seedCount++] = ((uint64_t)(below[x] + 1) << 32) | (last + x);
+        }
+    }
+    qsort(band->seeds, seedCount, sizeof(uint64_t), CompareSeeds);
+
+    size_t head = 0;
+    size_t tail = 0;
+    size_t next = 0;
+    BOOL changed = FALSE;
+    while(next < seedCount || head < tail)
+    {
+        uint32_t cell;
+        uint32_t value;
+        // Seeds go first on ties, so a queued cell is never lowered afterwards
+        if(next < seedCount && (head == tail || (uint32_t)(band->seeds[next] >> 32) <= distance[band->fifo[head]]))
+        {
+            cell = (uint32_t)band->seeds[next];
+            value = (uint32_t)(band->seeds[next++] >> 32);
+            if(value >= distance[cell])
+            {
+                continue;
+            }
+            Improve(band, cell, value, up, down);
+            changed = TRUE;
+        }
+        else
+        {
+            cell = band->fifo[head++];
+            value = distance[cell];
+        }
+        (*expanded)++;
+        int x = cell % width;
+        int y = cell / width;
+        for(int i = 0; i < 4; i++)
+        {
+            int nx = x + offsets[i][0];
+            int ny = y + offsets[i][1];
+            if(nx < 0 || nx >= width || ny < 0 || ny >= band->loaded || !Open(band, ny + 1, nx))
+            {
+                continue;
+            }
+            uint32_t neighbour = (uint32_t)ny * width + nx;
+            if(value + 1 < distance[neighbour])
+            {
+                Improve(band, neighbour, value + 1, up, down);
+                band->fifo[tail++] = neighbour;
+                changed = TRUE;
+            }
+        }
+    }
+    return changed;
+}
+
+/*
+    Return the distance of a map cell of the loaded band or its halo rows
+*/
+static inline uint32_t Distance(const Band * band, int x, int y)
+{
+    return band->distance[(size_t)(y - band->first + 1) * band->width + x];
+}
+
+/*
+    Free the buffers and close the files of a band
+*/
+static void DestroyBand(Band * band)
+{
+    free(band->walls);
+    free(band->distance);
+    free(band->fifo);
+    free(band->seeds);
+    if(band->map)
+    {
+        fclose(band->map);
+    }
+    if(band->distances)
+    {
+        fclose(band->distances);
+    }
+}
+
+/*
+    Solve a packed binary map without loading it: the map is read in horizontal bands of rows, and
+    the distance of every cell from the start is kept in a scratch file. Each band is searched with
+    the distances of the rows above and below it as extra sources, and bands are searched again,
+    sweeping down and up, until no distance on a band boundary changes. The path is then walked
+    back from the end point to the neighbour one step closer, preferring N, S, E, W like Solve,
+    loading the band it crosses into
+    mapFile     = binary map saved from a MAP_PACKED map (map_convert <map> <map.bin> packed)
+    pathFile    = receives the path as "x y" lines from the end point back to the start, NULL for none
+    memory      = bytes of band state to keep in memory, picks the rows per band (at least one)
+    scratchFile = file to keep the distances in, removed afterwards. NULL for a temporary file
+    stats       = receives the work done and the memory held, can be NULL
+    Return FALSE if the files could not be read or written, memory ran out or the end point cannot be reached
+*/
+static BOOL Solve(const char * mapFile, const char * pathFile, size_t memory, const char * scratchFile,
+    ExternalStats * stats)
+{
+    ExternalStats counters;
+    memset(&counters, 0, sizeof(counters));
+    Band band;
+    memset(&band, 0, sizeof(band));
+    if((band.map = fopen(mapFile, "rb")) == NULL)
+    {
+        fprintf(stderr, "openerror for file, errno = %d\n", errno);
+        return FALSE;
+    }
+
+    MapHeader header;
+    int stride = 0;
+    if(fread(&header, sizeof(header), 1, band.map) == 1 && header.width > 0)
+    {
+        stride = (header.width + WORD_BITS - 1) / WORD_BITS;
+    }
+    if(stride == 0
+    || memcmp(header.magic, MAP_BINARY_MAGIC, 4) != 0
+    || header.version != MAP_BINARY_VERSION
+    || (header.format & MAP_STORED) != MAP_PACKED
+    || header.height <= 0
+    || header.dataSize != (uint64_t)stride * header.height * sizeof(uint64_t)
+    || header.start < 0 || header.start >= header.width
+    || header.end < 0 || header.end >= header.width)
+    {
+        fprintf(stderr, "%s is not a packed binary map\n", mapFile);
+        DestroyBand(&band);
+        return FALSE;
+    }
+    band.dataOffset = (int64_t)header.dataOffset;
+    band.width = header.width;
+    band.height = header.height;
+    band.stride = stride;
+
+    // Every band row holds its walls, distances and FIFO entries, the halo rows and seeds are fixed
+    size_t rowBytes = (size_t)stride * sizeof(uint64_t) + (size_t)band.width * sizeof(uint32_t);
+    size_t fixed = 2 * rowBytes + (2 * (size_t)band.width + 1) * sizeof(uint64_t);
+    size_t bandRowBytes = rowBytes + (size_t)band.width * sizeof(uint32_t);
+    size_t rows = (memory > fixed) ? (memory - fixed) / bandRowBytes : 1;
+    rows = __max(__min(rows, __min((size_t)band.height, UINT32_MAX / (size_t)band.width)), 1);
+    band.rows = (int)rows;
+    band.count = (band.height + band.rows - 1) / band.rows;
+    counters.bandRows = band.rows;
+    counters.memory = fixed + rows * bandRowBytes + band.count;
+
+    band.walls = (uint64_t *)malloc((rows + 2) * stride * sizeof(uint64_t));
+    band.distance = (uint32_t *)malloc((rows + 2) * band.width * sizeof(uint32_t));
+    band.fifo = (uint32_t *)malloc(rows * band.width * sizeof(uint32_t));
+    band.seeds = (uint64_t *)malloc((2 * (size_t)band.width + 1) * sizeof(uint64_t));
+    BOOL * dirty = (BOOL *)calloc(band.count, sizeof(BOOL));
+    band.distances = scratchFile ? fopen(scratchFile, "w+b") : tmpfile();
+    BOOL success = band.walls && band.distance && band.fifo && band.seeds && dirty && band.distances
+        && ClearDistances(&band);
+
+    // Search the bands the start spreads to, sweeping down and up until the boundaries settle
+    BOOL pending = success;
+    if(success)
+    {
+        dirty[0] = TRUE;
+    }
+    for(int direction = 1; pending && success; direction = -direction)
+    {
+        counters.sweeps++;
+        for(int i = (direction > 0) ? 0 : band.count - 1; i >= 0 && i < band.count && success; i += direction)
+        {
+            if(!dirty[i])
+            {
+                continue;
+            }
+            dirty[i] = FALSE;
+            BOOL up = FALSE;
+            BOOL down = FALSE;
+            success = LoadBand(&band, i, TRUE);
+            counters.bandLoads++;
+            if(success && Relax(&band, header.start, &up, &down, &counters.expanded))
+            {
+                success = StoreBand(&band);
+            }
+            dirty[__max(i - 1, 0)] |= up;
+            dirty[__min(i + 1, band.count - 1)] |= down;
+        }
+        pending = FALSE;
+        for(int i = 0; i < band.count && !pending; i++)
+        {
+            pending = dirty[i];
+        }
+    }
+
+    // Walk back from the end point, one step closer to the start at a time
+    int x = header.end;
+    int y = band.height - 1;
+    success = success && LoadBand(&band, y / band.rows, FALSE);
+    counters.bandLoads++;
+    BOOL found = success && Distance(&band, x, y) != DISTANCE_NONE;
+    FILE * path = NULL;
+    if(found && pathFile && (path = fopen(pathFile, "w")) == NULL)
+    {
+        fprintf(stderr, "openerror for file, errno = %d\n", errno);
+        success = FALSE;
+    }
+    while(found && success)
+    {
+        uint32_t value = Distance(&band, x, y);
+        counters.length++;
+        if(path)
+        {
+            fprintf(path, "%d %d\n", x, y);
+        }
+        if(value == 0)
+        {
+            break;
+        }
+        if(y > 0 && Distance(&band, x, y - 1) == value - 1)
+        {
+            y--;
+        }
+        else if(y + 1 < band.height && Distance(&band, x, y + 1) == value - 1)
+        {
+            y++;
+        }
+        else if(x + 1 < band.width && Distance(&band, x + 1, y) == value - 1)
+        {
+            x++;
+        }
+        else
+        {
+            x--;
+        }
+        if(y < band.first || y >= band.first + band.loaded)
+        {
+            success = LoadBand(&band, y / band.rows, FALSE);
+            counters.bandLoads++;
+        }
+    }
+    if(path)
+    {
+        success &= !ferror(path);
+        success &= fclose(path) == 0;
+    }
+
+    free(dirty);
+    DestroyBand(&band);
+    if(scratchFile)
+    {
+        remove(scratchFile);
+    }
+    if(stats)
+    {
+        (*stats) = counters;
+    }
+    return success && found;
+}
+
+// External namespace struct, contains function pointers related to out-of-core solving
+const struct external_namespace External_namespace =
+{
+    .Solve = Solve
+};
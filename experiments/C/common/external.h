@@ -0,0 +1,29 @@
+#ifndef EXTERNAL_H
+#define EXTERNAL_H
+
+#include "common.h"
+
+#define EXTERNAL_MEMORY (64 << 20)  // Default bytes of band state kept in memory
+
+/*
+    Work done by an out-of-core solve, and the memory it held
+*/
+typedef struct ExternalStats
+{
+    size_t expanded;    // Cells expanded over every visit of every band
+    size_t bandLoads;   // Bands read from disk, by the search and the walk back
+    int sweeps;         // Passes over the bands until no boundary distance changed
+    int bandRows;       // Map rows per band
+    size_t memory;      // Bytes of band state held in memory
+    size_t length;      // Cells on the path, 0 if the end point cannot be reached
+} ExternalStats;
+
+typedef struct external_namespace
+{
+    BOOL (* Solve)(const char * mapFile, const char * pathFile, size_t memory, const char * scratchFile,
+        ExternalStats * stats);
+} external_namespace;
+
+extern const struct external_namespace External_namespace;
+
+#endif // EXTERNAL_H
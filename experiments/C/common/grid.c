@@ -0,0 +1,161 @@
+#include "grid.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    Return the ARGB8888 colour a cell value is drawn with
+*/
+static inline uint32_t CellColour(unsigned int value)
+{
+    switch(value)
+    {
+    case WALL:
+        return 0xFF3622C7;
+    case PATH:
+        return 0xFF36C722;
+    case FREE:
+        return 0xFFFFFFFF;
+    default: // Route candidate
+        return 0xFFFFA500;
+    }
+}
+
+/*
+    Free the texture and buffers
+*/
+static void Destroy(GridRenderer * grid)
+{
+    if(grid->pTexture)
+    {
+        SDL_DestroyTexture(grid->pTexture);
+    }
+    free(grid->pixels);
+    free(grid->dirty);
+    free(grid->marked);
+    memset(grid, 0, sizeof(GridRenderer));
+}
+
+/*
+    Create the streaming texture and buffers for a map of the given size
+    Everything is drawn on the first frame
+    Return FALSE if the texture or memory could not be allocated
+*/
+static BOOL Init(GridRenderer * grid, SDL_Renderer * pRenderer, int width, int height)
+{
+    memset(grid, 0, sizeof(GridRenderer));
+    size_t cells = (size_t)width * height;
+    grid->pRenderer     = pRenderer;
+    grid->width         = width;
+    grid->height        = height;
+    grid->full          = TRUE;
+    grid->dirtyCapacity = __max(cells / 8, 64);
+    grid->pTexture  = SDL_CreateTexture(pRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+    grid->pixels    = (uint32_t *)malloc(cells * sizeof(uint32_t));
+    grid->dirty     = (uint32_t *)malloc(grid->dirtyCapacity * sizeof(uint32_t));
+    grid->marked    = (uint8_t *)calloc(cells, 1);
+    if(!grid->pTexture || !grid->pixels || !grid->dirty || !grid->marked)
+    {
+        Destroy(grid);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+    Mark a cell to be recoloured on the next frame. Cells outside the map are ignored
+*/
+static void Mark(GridRenderer * grid, int x, int y)
+{
+    if((unsigned int)x >= (unsigned int)grid->width || (unsigned int)y >= (unsigned int)grid->height || grid->full)
+    {
+        return;
+    }
+    uint32_t cell = (uint32_t)y * grid->width + x;
+    if(grid->marked[cell])
+    {
+        return;
+    }
+    if(grid->dirtyCount == grid->dirtyCapacity)
+    {
+        grid->full = TRUE; // Cheaper to redo everything than to track this many cells
+        return;
+    }
+    grid->marked[cell] = 1;
+    grid->dirty[grid->dirtyCount++] = cell;
+}
+
+/*
+    Recolour every cell on the next frame, after changes too many or too scattered to mark
+*/
+static void MarkAll(GridRenderer * grid)
+{
+    grid->full = TRUE;
+}
+
+/*
+    Recolour the marked cells from the map, upload the rows they span and present the frame,
+    scaled to fit the window with the map's aspect ratio
+*/
+static void Draw(GridRenderer * grid, Map * map)
+{
+    int firstRow = grid->height;
+    int lastRow = -1;
+    if(grid->full)
+    {
+        for(int y = 0; y < grid->height; y++)
+        {
+            uint32_t * row = &grid->pixels[(size_t)y * grid->width];
+            for(int x = 0; x < grid->width; x++)
+            {
+                row[x] = CellColour(MapGetUnchecked(map, x, y));
+            }
+        }
+        firstRow = 0;
+        lastRow = grid->height - 1;
+    }
+    else
+    {
+        for(size_t i = 0; i < grid->dirtyCount; i++)
+        {
+            uint32_t cell = grid->dirty[i];
+            int x = cell % grid->width;
+            int y = cell / grid->width;
+            grid->pixels[cell] = CellColour(MapGetUnchecked(map, x, y));
+            firstRow = __min(firstRow, y);
+            lastRow = __max(lastRow, y);
+        }
+    }
+    for(size_t i = 0; i < grid->dirtyCount; i++)
+    {
+        grid->marked[grid->dirty[i]] = 0;
+    }
+    grid->dirtyCount = 0;
+    grid->full = FALSE;
+
+    if(lastRow >= firstRow)
+    {
+        SDL_Rect rows = {0, firstRow, grid->width, lastRow - firstRow + 1};
+        SDL_UpdateTexture(grid->pTexture, &rows, &grid->pixels[(size_t)firstRow * grid->width], grid->width * sizeof(uint32_t));
+    }
+
+    int outputWidth;
+    int outputHeight;
+    SDL_GetRendererOutputSize(grid->pRenderer, &outputWidth, &outputHeight);
+    double scale = __min((double)outputWidth / grid->width, (double)outputHeight / grid->height);
+    SDL_Rect target = {0, 0, (int)(grid->width * scale), (int)(grid->height * scale)};
+    SDL_SetRenderDrawColor(grid->pRenderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
+    SDL_RenderClear(grid->pRenderer);
+    SDL_RenderCopy(grid->pRenderer, grid->pTexture, NULL, &target);
+    SDL_RenderPresent(grid->pRenderer);
+}
+
+// Grid namespace struct, contains function pointers related to the GridRenderer struct
+const struct grid_namespace Grid_namespace =
+{
+    .Init = Init,
+    .Destroy = Destroy,
+    .Mark = Mark,
+    .MarkAll = MarkAll,
+    .Draw = Draw
+};
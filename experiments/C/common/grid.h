@@ -0,0 +1,39 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include "common.h"
+
+#include <SDL2/SDL.h>
+
+/*
+    Draws a map as one streaming texture with a pixel per cell, scaled to the window by the renderer
+    Only cells marked dirty since the last frame are recoloured, and only the rows they span are
+    uploaded, so a frame costs about as much as the cells that changed. Works with the software
+    renderer too (SDL_VIDEODRIVER=dummy)
+*/
+typedef struct GridRenderer
+{
+    SDL_Renderer * pRenderer;
+    SDL_Texture * pTexture;
+    int width;
+    int height;
+    uint32_t * pixels;      // ARGB8888 colour of every cell, row-major
+    uint32_t * dirty;       // Row-major cells marked since the last frame
+    size_t dirtyCount;
+    size_t dirtyCapacity;   // Past this many marks the whole map is refreshed instead
+    uint8_t * marked;       // 1 for cells already in dirty
+    BOOL full;              // Refresh every cell on the next frame
+} GridRenderer;
+
+typedef struct grid_namespace
+{
+    BOOL (* Init)(GridRenderer * grid, SDL_Renderer * pRenderer, int width, int height);
+    void (* Destroy)(GridRenderer * grid);
+    void (* Mark)(GridRenderer * grid, int x, int y);
+    void (* MarkAll)(GridRenderer * grid);
+    void (* Draw)(GridRenderer * grid, Map * map);
+} grid_namespace;
+
+extern const struct grid_namespace Grid_namespace;
+
+#endif // GRID_H
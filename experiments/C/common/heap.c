@@ -0,0 +1,181 @@
+#include "heap.h"
+#include "arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    Make sure the heap can hold at least the given number of entries without growing
+    Return FALSE if memory could not be allocated, the heap is left untouched
+*/
+static BOOL Reserve(Heap * heap, size_t capacity)
+{
+    if(capacity <= heap->capacity)
+    {
+        return TRUE;
+    }
+    // Fall back to malloc once the arena is exhausted
+    HeapEntry * data = heap->arena ? (HeapEntry *)Arena_namespace.Alloc(heap->arena, capacity * sizeof(HeapEntry)) : NULL;
+    BOOL owned = (data == NULL);
+    data = owned ? (HeapEntry *)malloc(capacity * sizeof(HeapEntry)) : data;
+    if(!data)
+    {
+        return FALSE;
+    }
+    if(heap->count)
+    {
+        memcpy(data, heap->data, heap->count * sizeof(HeapEntry));
+    }
+    if(heap->owned)
+    {
+        free(heap->data);
+    }
+    heap->data      = data;
+    heap->owned     = owned;
+    heap->capacity  = capacity;
+    return TRUE;
+}
+
+/*
+    Initialise an empty heap that allocates from an arena
+    capacity = number of entries to reserve up front (can be 0)
+    arena    = arena to allocate from, NULL to use malloc. Buffers that do not fit in the arena are malloced
+*/
+static BOOL InitArena(Heap * heap, size_t capacity, Arena * arena)
+{
+    heap->data      = NULL;
+    heap->capacity  = 0;
+    heap->count     = 0;
+    heap->arena     = arena;
+    heap->owned     = FALSE;
+    return Reserve(heap, capacity ? capacity : 16);
+}
+
+/*
+    Initialise an empty heap
+    capacity = number of entries to reserve up front (can be 0)
+*/
+static BOOL Init(Heap * heap, size_t capacity)
+{
+    return InitArena(heap, capacity, NULL);
+}
+
+/*
+    Free the heap memory. Arena memory is left for the arena owner to reset
+*/
+static void Destroy(Heap * heap)
+{
+    if(heap->owned)
+    {
+        free(heap->data);
+    }
+    heap->data      = NULL;
+    heap->owned     = FALSE;
+    heap->capacity  = 0;
+    heap->count     = 0;
+}
+
+/*
+    Add an entry, moving it up past every parent with a larger key
+    Return FALSE if the heap had to grow and memory could not be allocated
+*/
+static BOOL Push(Heap * heap, uint64_t key, uint32_t value)
+{
+    if(heap->count == heap->capacity && !Reserve(heap, heap->capacity * 2))
+    {
+        return FALSE;
+    }
+    size_t slot = heap->count++;
+    while(slot > 0)
+    {
+        size_t parent = (slot - 1) / 2;
+        if(heap->data[parent].key <= key)
+        {
+            break;
+        }
+        heap->data[slot] = heap->data[parent];
+        slot = parent;
+    }
+    heap->data[slot].key    = key;
+    heap->data[slot].value  = value;
+    return TRUE;
+}
+
+/*
+    Remove the entry with the smallest key and copy it into entry
+    The last entry takes its place and sinks down past every smaller child
+    Return FALSE if the heap is empty
+*/
+static BOOL Pop(Heap * heap, HeapEntry * entry)
+{
+    if(!heap->count)
+    {
+        return FALSE;
+    }
+    (*entry) = heap->data[0];
+    HeapEntry last = heap->data[--heap->count];
+    size_t slot = 0;
+    while(TRUE)
+    {
+        size_t child = slot * 2 + 1;
+        if(child >= heap->count)
+        {
+            break;
+        }
+        if(child + 1 < heap->count && heap->data[child + 1].key < heap->data[child].key)
+        {
+            child++;
+        }
+        if(last.key <= heap->data[child].key)
+        {
+            break;
+        }
+        heap->data[slot] = heap->data[child];
+        slot = child;
+    }
+    heap->data[slot] = last;
+    return TRUE;
+}
+
+/*
+    Copy the entry with the smallest key into entry without removing it
+    Return FALSE if the heap is empty
+*/
+static BOOL Peek(Heap * heap, HeapEntry * entry)
+{
+    if(!heap->count)
+    {
+        return FALSE;
+    }
+    (*entry) = heap->data[0];
+    return TRUE;
+}
+
+/*
+    Remove all entries, keeping the memory for reuse
+*/
+static void Clear(Heap * heap)
+{
+    heap->count = 0;
+}
+
+/*
+    Return the number of entries in the heap
+*/
+static size_t Size(Heap * heap)
+{
+    return heap->count;
+}
+
+// Heap namespace struct, contains function pointers related to the Heap struct
+const struct heap_namespace Heap_namespace =
+{
+    .Init = Init,
+    .InitArena = InitArena,
+    .Destroy = Destroy,
+    .Push = Push,
+    .Pop = Pop,
+    .Peek = Peek,
+    .Clear = Clear,
+    .Size = Size
+};
@@ -0,0 +1,43 @@
+#ifndef HEAP_H
+#define HEAP_H
+
+#include "common.h"
+
+/*
+    One element of a heap: a value ordered by its key
+*/
+typedef struct HeapEntry
+{
+    uint64_t key;   // Smallest key is popped first
+    uint32_t value;
+} HeapEntry;
+
+/*
+    Growable binary min heap of HeapEntry, stored in one flat array
+    Capacity doubles when full. Keys are compared as unsigned integers, so callers can pack
+    a priority and a tie breaker into one key
+*/
+typedef struct Heap
+{
+    HeapEntry * data;
+    size_t capacity;    // Number of entries that fit before growing
+    size_t count;       // Number of entries in the heap
+    struct Arena * arena; // Arena to allocate the buffer from, NULL for malloc
+    BOOL owned;         // The buffer was malloced and is freed by the heap
+} Heap;
+
+typedef struct heap_namespace
+{
+    BOOL (* Init)(Heap * heap, size_t capacity);
+    BOOL (* InitArena)(Heap * heap, size_t capacity, struct Arena * arena);
+    void (* Destroy)(Heap * heap);
+    BOOL (* Push)(Heap * heap, uint64_t key, uint32_t value);
+    BOOL (* Pop)(Heap * heap, HeapEntry * entry);
+    BOOL (* Peek)(Heap * heap, HeapEntry * entry);
+    void (* Clear)(Heap * heap);
+    size_t (* Size)(Heap * heap);
+} heap_namespace;
+
+extern const struct heap_namespace Heap_namespace;
+
+#endif // HEAP_H
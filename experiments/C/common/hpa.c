@@ -0,0 +1,798 @@
+#include "hpa.h"
+#include "heap.h"
+#include "queue.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+    Edge collected while building, before the edges are grouped by node
+*/
+typedef struct BuildEdge
+{
+    uint32_t from;
+    uint32_t to;
+    uint32_t cost;
+} BuildEdge;
+
+/*
+    Growable array used while building, of 64-bit keys or of edges
+*/
+typedef struct BuildList
+{
+    void * items;
+    size_t itemSize;
+    size_t count;
+    size_t capacity;
+} BuildList;
+
+/*
+    Breadth first search confined to one cluster, with distances indexed inside the cluster
+*/
+typedef struct ClusterFlood
+{
+    int x0;             // Bounds of the cluster, x1 and y1 exclusive
+    int y0;
+    int x1;
+    int y1;
+    int size;           // Row length of distance, the cluster size
+    uint32_t * distance; // Distance from the source plus one, 0 where not reached
+    Queue queue;
+} ClusterFlood;
+
+/*
+    Return TRUE if a path can go through the cell: inside the map and not a WALL
+*/
+static inline BOOL Walkable(const Map * map, int x, int y)
+{
+    return MapInBounds(map, x, y) && MapGetUnchecked(map, x, y) != WALL;
+}
+
+/*
+    Return the cluster a row-major cell belongs to
+*/
+static inline int CellCluster(const HpaGraph * graph, uint32_t cell)
+{
+    int x = cell % graph->width;
+    int y = cell / graph->width;
+    return (y / graph->clusterSize) * graph->clustersX + x / graph->clusterSize;
+}
+
+/*
+    Add an item to a build list, doubling its capacity when full
+    Return FALSE if memory could not be allocated
+*/
+static BOOL AppendItem(BuildList * list, const void * item)
+{
+    if(list->count == list->capacity)
+    {
+        size_t capacity = list->capacity ? list->capacity * 2 : 256;
+        void * items = realloc(list->items, capacity * list->itemSize);
+        if(!items)
+        {
+            return FALSE;
+        }
+        list->items     = items;
+        list->capacity  = capacity;
+    }
+    memcpy((char *)list->items + list->count * list->itemSize, item, list->itemSize);
+    list->count++;
+    return TRUE;
+}
+
+/*
+    qsort comparison of two 64-bit keys
+*/
+static int CompareKeys(const void * a, const void * b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/*
+    FNV-1a hash of the map size and walls, read a row word at a time so every format hashes alike
+*/
+static uint64_t HashMap(const Map * map)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    uint64_t words[2] = {(uint64_t)map->width, (uint64_t)map->height};
+    for(int i = 0; i < 2; i++)
+    {
+        hash = (hash ^ words[i]) * 0x100000001B3ULL;
+    }
+    int stride = (map->width + 63) / 64;
+    for(int y = 0; y < map->height; y++)
+    {
+        for(int w = 0; w < stride; w++)
+        {
+            hash = (hash ^ Map_namespace.GetRowWord((Map *)map, y, w)) * 0x100000001B3ULL;
+        }
+    }
+    return hash;
+}
+
+/*
+    Return the node of a cell, or UINT32_MAX if the cell is not a node
+    Nodes are sorted inside their cluster, so this is a binary search of one cluster
+*/
+static uint32_t FindNode(const HpaGraph * graph, uint32_t cell)
+{
+    int cluster = CellCluster(graph, cell);
+    uint32_t first = graph->clusterFirst[cluster];
+    uint32_t last = graph->clusterFirst[cluster + 1];
+    while(first < last)
+    {
+        uint32_t middle = first + (last - first) / 2;
+        if(graph->nodeCells[middle] < cell)
+        {
+            first = middle + 1;
+        }
+        else
+        {
+            last = middle;
+        }
+    }
+    return (first < graph->clusterFirst[cluster + 1] && graph->nodeCells[first] == cell) ? first : UINT32_MAX;
+}
+
+/*
+    Prepare the buffers of a cluster search
+    Return FALSE if memory could not be allocated
+*/
+static BOOL InitFlood(ClusterFlood * flood, int clusterSize)
+{
+    flood->size     = clusterSize;
+    flood->distance = (uint32_t *)malloc((size_t)clusterSize * clusterSize * sizeof(uint32_t));
+    if(!flood->distance)
+    {
+        return FALSE;
+    }
+    if(!Queue_namespace.Init(&flood->queue, sizeof(Node), clusterSize * 4))
+    {
+        free(flood->distance);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static void DestroyFlood(ClusterFlood * flood)
+{
+    free(flood->distance);
+    Queue_namespace.Destroy(&flood->queue);
+}
+
+/*
+    Flood one cluster breadth first from a source cell inside it, never leaving the cluster
+    Return FALSE if the queue could not grow
+*/
+static BOOL FloodCluster(const HpaGraph * graph, const Map * map, ClusterFlood * flood, int cluster, uint32_t source)
+{
+    static const int offsets[4][2] = {{0, -1}, {0, 1}, {1, 0}, {-1, 0}}; // N, S, E, W
+    flood->x0 = (cluster % graph->clustersX) * graph->clusterSize;
+    flood->y0 = (cluster / graph->clustersX) * graph->clusterSize;
+    flood->x1 = __min(flood->x0 + graph->clusterSize, map->width);
+    flood->y1 = __min(flood->y0 + graph->clusterSize, map->height);
+    memset(flood->distance, 0, (size_t)flood->size * flood->size * sizeof(uint32_t));
+    Queue_namespace.Clear(&flood->queue);
+
+    Node node = {source % map->width, source / map->width};
+    flood->distance[(node.y - flood->y0) * flood->size + node.x - flood->x0] = 1;
+    BOOL running = Queue_namespace.Push(&flood->queue, &node);
+    while(running && Queue_namespace.Pop(&flood->queue, &node))
+    {
+        uint32_t distance = flood->distance[(node.y - flood->y0) * flood->size + node.x - flood->x0] + 1;
+        for(int i = 0; i < 4 && running; i++)
+        {
+            Node next = {node.x + offsets[i][0], node.y + offsets[i][1]};
+            if(next.x < flood->x0 || next.x >= flood->x1 || next.y < flood->y0 || next.y >= flood->y1
+                || MapGetUnchecked(map, next.x, next.y) == WALL)
+            {
+                continue;
+            }
+            uint32_t * cell = &flood->distance[(next.y - flood->y0) * flood->size + next.x - flood->x0];
+            if(!(*cell))
+            {
+                (*cell) = distance;
+                running = Queue_namespace.Push(&flood->queue, &next);
+            }
+        }
+    }
+    return running;
+}
+
+/*
+    Return the flood distance of a row-major cell plus one, 0 if outside the cluster or not reached
+*/
+static inline uint32_t FloodDistance(const ClusterFlood * flood, uint32_t cell, int width)
+{
+    int x = cell % width;
+    int y = cell / width;
+    if(x < flood->x0 || x >= flood->x1 || y < flood->y0 || y >= flood->y1)
+    {
+        return 0;
+    }
+    return flood->distance[(y - flood->y0) * flood->size + x - flood->x0];
+}
+
+/*
+    Write the cells of the flood's shortest path from its source to target, source first
+    Walks back from target to the neighbour one closer, preferring N, S, E, W
+    path = receives FloodDistance(target) cells
+*/
+static void TraceCluster(const ClusterFlood * flood, int width, uint32_t target, Node * path)
+{
+    int x = target % width;
+    int y = target / width;
+    for(uint32_t distance = FloodDistance(flood, target, width); distance > 0; distance--)
+    {
+        path[distance - 1].x = x;
+        path[distance - 1].y = y;
+        uint32_t closer = distance - 1;
+        if(y > flood->y0 && flood->distance[(y - 1 - flood->y0) * flood->size + x - flood->x0] == closer)
+        {
+            y--;
+        }
+        else if(y + 1 < flood->y1 && flood->distance[(y + 1 - flood->y0) * flood->size + x - flood->x0] == closer)
+        {
+            y++;
+        }
+        else if(x + 1 < flood->x1 && flood->distance[(y - flood->y0) * flood->size + x + 1 - flood->x0] == closer)
+        {
+            x++;
+        }
+        else
+        {
+            x--;
+        }
+    }
+}
+
+/*
+    Find the runs of open cell pairs along one border between two clusters and add their entrances
+    The cells of border position i are (x + i * dx, y + i * dy) and the same moved by (ox, oy)
+    cells = receives the node cells, keyed by cluster then cell
+    pairs = receives the joined cell pairs of every entrance
+    Return FALSE if memory could not be allocated
+*/
+static BOOL AddBorder(const HpaGraph * graph, const Map * map, BuildList * cells, BuildList * pairs,
+    int x, int y, int dx, int dy, int ox, int oy, int length)
+{
+    BOOL running = TRUE;
+    int runStart = -1;
+    for(int i = 0; i <= length && running; i++)
+    {
+        int ax = x + i * dx;
+        int ay = y + i * dy;
+        BOOL open = i < length && Walkable(map, ax, ay) && Walkable(map, ax + ox, ay + oy);
+        if(open && runStart < 0)
+        {
+            runStart = i;
+        }
+        else if(!open && runStart >= 0)
+        {
+            // Short entrances get one node in the middle, long ones one at each end
+            int runLength = i - runStart;
+            int positions[2] = {runStart + runLength / 2, -1};
+            if(runLength >= HPA_SPLIT_LENGTH)
+            {
+                positions[0] = runStart;
+                positions[1] = i - 1;
+            }
+            for(int ii = 0; ii < 2 && positions[ii] >= 0 && running; ii++)
+            {
+                uint32_t a = (uint32_t)(y + positions[ii] * dy) * map->width + x + positions[ii] * dx;
+                uint32_t b = a + (uint32_t)oy * map->width + ox;
+                uint64_t keys[3] = {((uint64_t)CellCluster(graph, a) << 32) | a, ((uint64_t)CellCluster(graph, b) << 32) | b,
+                    ((uint64_t)a << 32) | b};
+                running = AppendItem(cells, &keys[0]) && AppendItem(cells, &keys[1]) && AppendItem(pairs, &keys[2]);
+            }
+            runStart = -1;
+        }
+    }
+    return running;
+}
+
+/*
+    Free the graph
+*/
+static void Destroy(HpaGraph * graph)
+{
+    free(graph->nodeCells);
+    free(graph->clusterFirst);
+    free(graph->edgeFirst);
+    free(graph->edges);
+    graph->nodeCells    = NULL;
+    graph->clusterFirst = NULL;
+    graph->edgeFirst    = NULL;
+    graph->edges        = NULL;
+    graph->nodeCount    = 0;
+    graph->edgeCount    = 0;
+}
+
+/*
+    Group collected edges by their start node into the graph's edge arrays
+    Return FALSE if memory could not be allocated
+*/
+static BOOL GroupEdges(HpaGraph * graph, const BuildList * list)
+{
+    const BuildEdge * edges = (const BuildEdge *)list->items;
+    graph->edgeCount = (uint32_t)list->count;
+    graph->edgeFirst = (uint32_t *)calloc(graph->nodeCount + 1, sizeof(uint32_t));
+    graph->edges = (HpaEdge *)malloc((list->count ? list->count : 1) * sizeof(HpaEdge));
+    if(!graph->edgeFirst || !graph->edges)
+    {
+        return FALSE;
+    }
+    for(size_t i = 0; i < list->count; i++)
+    {
+        graph->edgeFirst[edges[i].from + 1]++;
+    }
+    for(uint32_t i = 0; i < graph->nodeCount; i++)
+    {
+        graph->edgeFirst[i + 1] += graph->edgeFirst[i];
+    }
+    // Fill using the starts as cursors, then shift them back
+    for(size_t i = 0; i < list->count; i++)
+    {
+        HpaEdge * edge = &graph->edges[graph->edgeFirst[edges[i].from]++];
+        edge->to    = edges[i].to;
+        edge->cost  = edges[i].cost;
+    }
+    for(uint32_t i = graph->nodeCount; i > 0; i--)
+    {
+        graph->edgeFirst[i] = graph->edgeFirst[i - 1];
+    }
+    graph->edgeFirst[0] = 0;
+    return TRUE;
+}
+
+/*
+    Build the abstract graph of a map: find the entrances on every cluster border, then connect
+    the nodes of every cluster with the length of their shortest path inside it
+    clusterSize = width and height of a cluster, 0 for HPA_CLUSTER_SIZE
+    Return FALSE if memory could not be allocated
+*/
+static BOOL Build(HpaGraph * graph, const Map * map, int clusterSize)
+{
+    memset(graph, 0, sizeof(HpaGraph));
+    graph->width        = map->width;
+    graph->height       = map->height;
+    graph->clusterSize  = clusterSize > 0 ? clusterSize : HPA_CLUSTER_SIZE;
+    graph->clustersX    = (map->width + graph->clusterSize - 1) / graph->clusterSize;
+    graph->clustersY    = (map->height + graph->clusterSize - 1) / graph->clusterSize;
+    graph->mapHash      = HashMap(map);
+    graph->mapRevision  = map->revision;
+    int clusters = graph->clustersX * graph->clustersY;
+    int size = graph->clusterSize;
+
+    // Entrances of every vertical, then every horizontal border
+    BuildList cells = {NULL, sizeof(uint64_t), 0, 0};
+    BuildList pairs = {NULL, sizeof(uint64_t), 0, 0};
+    BuildList edges = {NULL, sizeof(BuildEdge), 0, 0};
+    BOOL running = TRUE;
+    for(int cy = 0; cy < graph->clustersY && running; cy++)
+    {
+        for(int cx = 0; cx < graph->clustersX && running; cx++)
+        {
+            int x = cx * size;
+            int y = cy * size;
+            if(cx + 1 < graph->clustersX)
+            {
+                running = AddBorder(graph, map, &cells, &pairs, x + size - 1, y, 0, 1, 1, 0, __min(size, map->height - y));
+            }
+            if(cy + 1 < graph->clustersY && running)
+            {
+                running = AddBorder(graph, map, &cells, &pairs, x, y + size - 1, 1, 0, 0, 1, __min(size, map->width - x));
+            }
+        }
+    }
+
+    // Unique node cells, grouped by cluster
+    if(running)
+    {
+        uint64_t * keys = (uint64_t *)cells.items;
+        if(cells.count)
+        {
+            qsort(keys, cells.count, sizeof(uint64_t), CompareKeys);
+        }
+        graph->nodeCells = (uint32_t *)malloc((cells.count ? cells.count : 1) * sizeof(uint32_t));
+        graph->clusterFirst = (uint32_t *)calloc(clusters + 1, sizeof(uint32_t));
+        running = graph->nodeCells && graph->clusterFirst;
+        for(size_t i = 0; i < cells.count && running; i++)
+        {
+            if(i == 0 || keys[i] != keys[i - 1])
+            {
+                graph->nodeCells[graph->nodeCount++] = (uint32_t)keys[i];
+                graph->clusterFirst[(keys[i] >> 32) + 1]++;
+            }
+        }
+        for(int i = 0; i < clusters && running; i++)
+        {
+            graph->clusterFirst[i + 1] += graph->clusterFirst[i];
+        }
+    }
+
+    // One step edges across every entrance
+    const uint64_t * joined = (const uint64_t *)pairs.items;
+    for(size_t i = 0; i < pairs.count && running; i++)
+    {
+        uint32_t a = FindNode(graph, (uint32_t)(joined[i] >> 32));
+        uint32_t b = FindNode(graph, (uint32_t)joined[i]);
+        BuildEdge forward = {a, b, 1};
+        BuildEdge backward = {b, a, 1};
+        running = AppendItem(&edges, &forward) && AppendItem(&edges, &backward);
+    }
+
+    // Shortest paths between the nodes of every cluster, staying inside it
+    ClusterFlood flood;
+    if(running && InitFlood(&flood, size))
+    {
+        for(int cluster = 0; cluster < clusters && running; cluster++)
+        {
+            for(uint32_t i = graph->clusterFirst[cluster]; i < graph->clusterFirst[cluster + 1] && running; i++)
+            {
+                running = FloodCluster(graph, map, &flood, cluster, graph->nodeCells[i]);
+                for(uint32_t ii = graph->clusterFirst[cluster]; ii < graph->clusterFirst[cluster + 1] && running; ii++)
+                {
+                    uint32_t distance = FloodDistance(&flood, graph->nodeCells[ii], map->width);
+                    if(ii != i && distance)
+                    {
+                        BuildEdge edge = {i, ii, distance - 1};
+                        running = AppendItem(&edges, &edge);
+                    }
+                }
+            }
+        }
+        DestroyFlood(&flood);
+    }
+    else
+    {
+        running = FALSE;
+    }
+
+    running = running && GroupEdges(graph, &edges);
+    free(cells.items);
+    free(pairs.items);
+    free(edges.items);
+    if(!running)
+    {
+        Destroy(graph);
+    }
+    return running;
+}
+
+/*
+    Save the graph to a binary file, to be loaded next to its map
+    Return FALSE if the file could not be written
+*/
+static BOOL Save(const HpaGraph * graph, char * filename)
+{
+    FILE * file = fopen(filename, "wb");
+    if(!file)
+    {
+        printf("openerror for file %s\n", filename);
+        return FALSE;
+    }
+    HpaHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, HPA_MAGIC, 4);
+    header.version      = HPA_VERSION;
+    header.width        = graph->width;
+    header.height       = graph->height;
+    header.clusterSize  = graph->clusterSize;
+    header.nodeCount    = graph->nodeCount;
+    header.edgeCount    = graph->edgeCount;
+    header.mapHash      = graph->mapHash;
+    size_t clusters = (size_t)graph->clustersX * graph->clustersY;
+    BOOL success = fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(graph->nodeCells, sizeof(uint32_t), graph->nodeCount, file) == graph->nodeCount
+        && fwrite(graph->clusterFirst, sizeof(uint32_t), clusters + 1, file) == clusters + 1
+        && fwrite(graph->edgeFirst, sizeof(uint32_t), graph->nodeCount + 1, file) == graph->nodeCount + 1
+        && fwrite(graph->edges, sizeof(HpaEdge), graph->edgeCount, file) == graph->edgeCount;
+    success = (fclose(file) == 0) && success;
+    return success;
+}
+
+/*
+    Check the arrays of a loaded graph, so a damaged or foreign file cannot send a query out of them
+    Node cells must lie in the map and in their cluster, sorted inside it, both start arrays must
+    count up to the node and edge counts, and every edge must lead to a node in fewer steps than
+    the map has cells
+*/
+static BOOL CheckGraph(const HpaGraph * graph)
+{
+    uint32_t cells = (uint32_t)graph->width * graph->height;
+    int clusters = graph->clustersX * graph->clustersY;
+    if(graph->clusterFirst[0] != 0 || graph->clusterFirst[clusters] != graph->nodeCount
+        || graph->edgeFirst[0] != 0 || graph->edgeFirst[graph->nodeCount] != graph->edgeCount)
+    {
+        return FALSE;
+    }
+    for(int cluster = 0; cluster < clusters; cluster++)
+    {
+        uint32_t first = graph->clusterFirst[cluster];
+        uint32_t last = graph->clusterFirst[cluster + 1];
+        if(last < first || last > graph->nodeCount)
+        {
+            return FALSE;
+        }
+        for(uint32_t i = first; i < last; i++)
+        {
+            uint32_t cell = graph->nodeCells[i];
+            if(cell >= cells || CellCluster(graph, cell) != cluster || (i > first && cell <= graph->nodeCells[i - 1]))
+            {
+                return FALSE;
+            }
+        }
+    }
+    for(uint32_t i = 0; i < graph->nodeCount; i++)
+    {
+        if(graph->edgeFirst[i + 1] < graph->edgeFirst[i])
+        {
+            return FALSE;
+        }
+    }
+    for(uint32_t i = 0; i < graph->edgeCount; i++)
+    {
+        if(graph->edges[i].to >= graph->nodeCount || graph->edges[i].cost < 1 || graph->edges[i].cost >= cells)
+        {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/*
+    Load a graph saved with Save
+    map = map the graph is for, NULL to skip the check. The graph is refused if the map's walls changed.
+          Without a map the first Query on each map revision hashes the map's walls instead
+    Return FALSE if the file is missing, invalid or does not match the map
+*/
+static BOOL Load(HpaGraph * graph, char * filename, const Map * map)
+{
+    memset(graph, 0, sizeof(HpaGraph));
+    FILE * file = fopen(filename, "rb");
+    if(!file)
+    {
+        return FALSE;
+    }
+    HpaHeader header;
+    BOOL success = fread(&header, sizeof(header), 1, file) == 1
+        && memcmp(header.magic, HPA_MAGIC, 4) == 0
+        && header.version == HPA_VERSION
+        && header.clusterSize > 0 && header.width > 0 && header.height > 0
+        && (uint64_t)header.width * header.height <= INT32_MAX
+        && header.nodeCount <= (uint64_t)header.width * header.height
+        && (!map || (header.width == map->width && header.height == map->height && header.mapHash == HashMap(map)));
+    if(success)
+    {
+        graph->width        = header.width;
+        graph->height       = header.height;
+        graph->clusterSize  = header.clusterSize;
+        graph->clustersX    = (header.width + header.clusterSize - 1) / header.clusterSize;
+        graph->clustersY    = (header.height + header.clusterSize - 1) / header.clusterSize;
+        graph->mapHash      = header.mapHash;
+        graph->mapRevision  = map ? map->revision : 0;
+        graph->nodeCount    = header.nodeCount;
+        graph->edgeCount    = header.edgeCount;
+        size_t clusters = (size_t)graph->clustersX * graph->clustersY;
+        graph->nodeCells    = (uint32_t *)malloc((header.nodeCount ? header.nodeCount : 1) * sizeof(uint32_t));
+        graph->clusterFirst = (uint32_t *)malloc((clusters + 1) * sizeof(uint32_t));
+        graph->edgeFirst    = (uint32_t *)malloc((header.nodeCount + 1) * sizeof(uint32_t));
+        graph->edges        = (HpaEdge *)malloc((header.edgeCount ? header.edgeCount : 1) * sizeof(HpaEdge));
+        success = graph->nodeCells && graph->clusterFirst && graph->edgeFirst && graph->edges
+            && fread(graph->nodeCells, sizeof(uint32_t), header.nodeCount, file) == header.nodeCount
+            && fread(graph->clusterFirst, sizeof(uint32_t), clusters + 1, file) == clusters + 1
+            && fread(graph->edgeFirst, sizeof(uint32_t), header.nodeCount + 1, file) == header.nodeCount + 1
+            && fread(graph->edges, sizeof(HpaEdge), header.edgeCount, file) == header.edgeCount
+            && CheckGraph(graph);
+    }
+    fclose(file);
+    if(!success)
+    {
+        Destroy(graph);
+    }
+    return success;
+}
+
+/*
+    Find a path between two cells: search the abstract graph, with the start and end joined to the
+    nodes of their clusters, then refine every step of the abstract path inside its cluster
+    Cells in one cluster are first searched inside the cluster alone
+    path     = receives the cells from start to end if the path fits, can be NULL to only get the length
+    capacity = number of nodes path can hold
+    stats    = receives the work done (abstract nodes expanded), can be NULL
+    Return the number of cells of the path including both ends, or 0 if out of memory or unreachable
+*/
+static int Query(const HpaGraph * graph, const Map * map, Node start, Node end, Node * path, int capacity, SolverStats * stats)
+{
+    if(!Walkable(map, start.x, start.y) || !Walkable(map, end.x, end.y)
+        || map->width != graph->width || map->height != graph->height
+        || (map->revision != graph->mapRevision && HashMap(map) != graph->mapHash))
+    {
+        return 0;
+    }
+    uint32_t startCell = (uint32_t)start.y * map->width + start.x;
+    uint32_t endCell = (uint32_t)end.y * map->width + end.x;
+    int startCluster = CellCluster(graph, startCell);
+    int endCluster = CellCluster(graph, endCell);
+    ClusterFlood flood;
+    if(!InitFlood(&flood, graph->clusterSize))
+    {
+        return 0;
+    }
+    BOOL running = FloodCluster(graph, map, &flood, startCluster, startCell);
+    uint32_t local = FloodDistance(&flood, endCell, map->width);
+    if(running && local)
+    {
+        if(path && (int)local <= capacity)
+        {
+            TraceCluster(&flood, map->width, endCell, path);
+        }
+        if(stats)
+        {
+            stats->expanded = 0;
+        }
+        DestroyFlood(&flood);
+        return (int)local;
+    }
+
+    // Abstract nodes: the graph's, then the start and the end
+    uint32_t startNode = graph->nodeCount;
+    uint32_t endNode = graph->nodeCount + 1;
+    uint32_t * cost = (uint32_t *)malloc((graph->nodeCount + 2) * sizeof(uint32_t));
+    uint32_t * parent = (uint32_t *)malloc((graph->nodeCount + 2) * sizeof(uint32_t));
+    uint32_t * startCost = (uint32_t *)calloc(graph->clusterFirst[startCluster + 1] - graph->clusterFirst[startCluster] + 1, sizeof(uint32_t));
+    uint32_t * endCost = (uint32_t *)calloc(graph->clusterFirst[endCluster + 1] - graph->clusterFirst[endCluster] + 1, sizeof(uint32_t));
+    Heap heap;
+    BOOL queued = running && cost && parent && startCost && endCost && Heap_namespace.Init(&heap, 64);
+    running = queued;
+    if(running)
+    {
+        // Distances inside the end cluster are symmetric, flood it from the end
+        for(uint32_t i = graph->clusterFirst[startCluster]; i < graph->clusterFirst[startCluster + 1]; i++)
+        {
+            startCost[i - graph->clusterFirst[startCluster]] = FloodDistance(&flood, graph->nodeCells[i], map->width);
+        }
+        running = FloodCluster(graph, map, &flood, endCluster, endCell);
+        for(uint32_t i = graph->clusterFirst[endCluster]; i < graph->clusterFirst[endCluster + 1] && running; i++)
+        {
+            endCost[i - graph->clusterFirst[endCluster]] = FloodDistance(&flood, graph->nodeCells[i], map->width);
+        }
+        memset(cost, 0xFF, (graph->nodeCount + 2) * sizeof(uint32_t));
+        cost[startNode] = 0;
+        running = running && Heap_namespace.Push(&heap, (uint64_t)(abs(start.x - end.x) + abs(start.y - end.y)) << 32, startNode);
+    }
+
+    // A* over the abstract graph, Manhattan distance to the end as heuristic
+    size_t expanded = 0;
+    HeapEntry entry;
+    while(running && Heap_namespace.Pop(&heap, &entry))
+    {
+        uint32_t node = entry.value;
+        uint32_t nodeCost = (uint32_t)entry.key;
+        if(nodeCost != cost[node])
+        {
+            continue; // Stale, the node was pushed again with a lower cost
+        }
+        if(node == endNode)
+        {
+            break;
+        }
+        expanded++;
+
+        // Candidate edges: the start's to its cluster, a node's own, and a node's to the end
+        uint32_t first = (node == startNode) ? graph->clusterFirst[startCluster] : graph->edgeFirst[node];
+        uint32_t last = (node == startNode) ? graph->clusterFirst[startCluster + 1] : graph->edgeFirst[node + 1];
+        for(uint32_t i = first; i <= last && running; i++)
+        {
+            uint32_t to;
+            uint32_t step;
+            if(i == last)
+            {
+                int cluster = (node == startNode) ? -1 : CellCluster(graph, graph->nodeCells[node]);
+                if(cluster != endCluster || !endCost[node - graph->clusterFirst[endCluster]])
+                {
+                    continue;
+                }
+                to = endNode;
+                step = endCost[node - graph->clusterFirst[endCluster]] - 1;
+            }
+            else if(node == startNode)
+            {
+                if(!startCost[i - first])
+                {
+                    continue;
+                }
+                to = i;
+                step = startCost[i - first] - 1;
+            }
+            else
+            {
+                to = graph->edges[i].to;
+                step = graph->edges[i].cost;
+            }
+            uint32_t toCost = nodeCost + step;
+            if(toCost < cost[to])
+            {
+                uint32_t toCell = (to == endNode) ? endCell : graph->nodeCells[to];
+                int x = toCell % map->width;
+                int y = toCell / map->width;
+                cost[to] = toCost;
+                parent[to] = node;
+                running = Heap_namespace.Push(&heap, ((uint64_t)(toCost + abs(x - end.x) + abs(y - end.y)) << 32) | toCost, to);
+            }
+        }
+    }
+    if(stats)
+    {
+        stats->expanded = expanded;
+    }
+
+    // Refine the abstract path back into cells, one step between two nodes at a time
+    int length = 0;
+    if(running && cost[endNode] < INT_MAX)
+    {
+        length = (int)cost[endNode] + 1;
+        if(path && length <= capacity)
+        {
+            int position = length - 1;
+            uint32_t node = endNode;
+            path[position] = end;
+            while(node != startNode && running)
+            {
+                uint32_t previous = parent[node];
+                uint32_t cell = (node == endNode) ? endCell : graph->nodeCells[node];
+                uint32_t previousCell = (previous == startNode) ? startCell : graph->nodeCells[previous];
+                int steps = (int)(cost[node] - cost[previous]);
+                if(steps < 0 || steps > position)
+                {
+                    running = FALSE;
+                }
+                else if(CellCluster(graph, cell) != CellCluster(graph, previousCell))
+                {
+                    running = steps == 1;
+                    path[position - 1].x = previousCell % map->width; // Across an entrance
+                    path[position - 1].y = previousCell / map->width;
+                }
+                else if(steps > 0)
+                {
+                    // The trace writes as many cells as the flood found, refuse edges that disagree
+                    running = FloodCluster(graph, map, &flood, CellCluster(graph, cell), previousCell)
+                        && FloodDistance(&flood, cell, map->width) == (uint32_t)steps + 1;
+                    if(running)
+                    {
+                        TraceCluster(&flood, map->width, cell, &path[position - steps]);
+                    }
+                }
+                position -= steps;
+                node = previous;
+            }
+            length = running ? length : 0;
+        }
+    }
+
+    if(queued)
+    {
+        Heap_namespace.Destroy(&heap);
+    }
+    free(cost);
+    free(parent);
+    free(startCost);
+    free(endCost);
+    DestroyFlood(&flood);
+    return length;
+}
+
+// Hpa namespace struct, contains function pointers related to the HpaGraph struct
+const struct hpa_namespace Hpa_namespace =
+{
+    .Build = Build,
+    .Destroy = Destroy,
+    .Save = Save,
+    .Load = Load,
+    .Query = Query
+};
@@ -0,0 +1,74 @@
+#ifndef HPA_H
+#define HPA_H
+
+#include "common.h"
+#include "solver.h"
+
+#define HPA_CLUSTER_SIZE    32      // Default width and height of a cluster, in cells
+#define HPA_SPLIT_LENGTH    6       // Entrances at least this long get a node at each end instead of one in the middle
+#define HPA_MAGIC           "HPAG"
+#define HPA_VERSION         1
+
+/*
+    Edge of the abstract graph: to another node, with the number of steps between the two cells
+*/
+typedef struct HpaEdge
+{
+    uint32_t to;
+    uint32_t cost;
+} HpaEdge;
+
+/*
+    Header at the start of a saved graph file (native byte order), followed by the node cells,
+    cluster starts, edge starts and edges
+*/
+typedef struct HpaHeader
+{
+    char     magic[4];      // HPA_MAGIC
+    uint32_t version;       // HPA_VERSION
+    int32_t  width;
+    int32_t  height;
+    int32_t  clusterSize;
+    uint32_t nodeCount;
+    uint32_t edgeCount;
+    uint32_t reserved;
+    uint64_t mapHash;
+} HpaHeader;
+
+/*
+    Abstract graph of a map for hierarchical path finding (HPA*)
+    The map is cut into square clusters. Every run of open cells along the border of two clusters is
+    an entrance with a node on each side, joined by a one step edge. Nodes of one cluster are joined
+    by the length of the shortest path between them inside the cluster. Queries search this small
+    graph and then refine only the clusters the path goes through. Paths are close to, but not always,
+    the shortest
+*/
+typedef struct HpaGraph
+{
+    int width;                  // Size of the map the graph was built for
+    int height;
+    int clusterSize;
+    int clustersX;
+    int clustersY;
+    uint64_t mapHash;           // Hash of the map's walls, to match a saved graph to its map
+    uint64_t mapRevision;       // Revision of the map at Build or Load, 0 if loaded without one. Query hashes the map otherwise
+    uint32_t nodeCount;
+    uint32_t edgeCount;
+    uint32_t * nodeCells;       // Row-major cell of every node, grouped by cluster and sorted inside it
+    uint32_t * clusterFirst;    // First node of every cluster, clusters + 1 entries
+    uint32_t * edgeFirst;       // First edge of every node, nodeCount + 1 entries
+    HpaEdge * edges;
+} HpaGraph;
+
+typedef struct hpa_namespace
+{
+    BOOL (* Build)(HpaGraph * graph, const Map * map, int clusterSize);
+    void (* Destroy)(HpaGraph * graph);
+    BOOL (* Save)(const HpaGraph * graph, char * filename);
+    BOOL (* Load)(HpaGraph * graph, char * filename, const Map * map);
+    int (* Query)(const HpaGraph * graph, const Map * map, Node start, Node end, Node * path, int capacity, SolverStats * stats);
+} hpa_namespace;
+
+extern const struct hpa_namespace Hpa_namespace;
+
+#endif // HPA_H
@@ -0,0 +1,317 @@
+#include "labels.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    Run of open cells in one row, x1 exclusive
+    parent links runs of one component together until the labels are written
+*/
+typedef struct LabelRun
+{
+    int x0;
+    int x1;
+    uint32_t parent;
+} LabelRun;
+
+/*
+    Return the root run of a component, halving the path on the way
+*/
+static uint32_t FindRoot(LabelRun * runs, uint32_t run)
+{
+    while(runs[run].parent != run)
+    {
+        runs[run].parent = runs[runs[run].parent].parent;
+        run = runs[run].parent;
+    }
+    return run;
+}
+
+/*
+    Join the components of two runs, keeping the older root so roots come before their runs
+*/
+static void Union(LabelRun * runs, uint32_t a, uint32_t b)
+{
+    a = FindRoot(runs, a);
+    b = FindRoot(runs, b);
+    if(a < b)
+    {
+        runs[b].parent = a;
+    }
+    else if(b < a)
+    {
+        runs[a].parent = b;
+    }
+}
+
+static inline void SetLabel(LabelPlane * plane, size_t index, uint32_t label)
+{
+    if(plane->wide)
+    {
+        ((uint32_t *)plane->labels)[index] = label;
+    }
+    else
+    {
+        ((uint16_t *)plane->labels)[index] = (uint16_t)label;
+    }
+}
+
+/*
+    Free the labels
+*/
+static void Destroy(LabelPlane * plane)
+{
+    free(plane->labels);
+    free(plane->sizes);
+    memset(plane, 0, sizeof(LabelPlane));
+}
+
+/*
+    Return 64 cells of a row as a bitmask, a set bit is an open cell
+    Packed maps are read a word at a time, other formats through the inline accessor
+*/
+static inline uint64_t OpenWord(const Map * map, int y, int word, int bits)
+{
+    if(map->format & MAP_PACKED)
+    {
+        return ~map->walls[(size_t)y * map->stride + word];
+    }
+    uint64_t open = 0;
+    for(int i = 0; i < bits; i++)
+    {
+        open |= (uint64_t)(MapGetUnchecked(map, word * WORD_BITS + i, y) != WALL) << i;
+    }
+    return open;
+}
+
+/*
+    Append a run, doubling the array when full
+    Return FALSE if memory ran out
+*/
+static BOOL AddRun(LabelRun ** runs, size_t * capacity, uint32_t * count, int x0, int x1)
+{
+    if((*count) == (*capacity))
+    {
+        LabelRun * grown = (LabelRun *)realloc(*runs, (*capacity) * 2 * sizeof(LabelRun));
+        if(!grown)
+        {
+            return FALSE;
+        }
+        (*runs) = grown;
+        (*capacity) *= 2;
+    }
+    LabelRun * run = &(*runs)[*count];
+    run->x0     = x0;
+    run->x1     = x1;
+    run->parent = (*count)++;
+    return TRUE;
+}
+
+/*
+    Find the runs of open cells of every row, skipping through a row word at a time, and join each
+    to the runs of the row above that share a column
+    rowFirst = receives the first run of every row, height + 1 entries
+    runCount = receives the number of runs
+    Return the runs, or NULL if memory ran out
+*/
+static LabelRun * ScanRuns(const Map * map, uint32_t * rowFirst, uint32_t * runCount)
+{
+    size_t capacity = (size_t)map->height * 4 + 64;
+    uint32_t count = 0;
+    LabelRun * runs = (LabelRun *)malloc(capacity * sizeof(LabelRun));
+    BOOL success = runs != NULL;
+    int stride = (map->width + WORD_BITS - 1) / WORD_BITS;
+    for(int y = 0; y < map->height && success; y++)
+    {
+        rowFirst[y] = count;
+        int runStart = -1;
+        for(int w = 0; w < stride && success; w++)
+        {
+            int bits = __min(map->width - w * WORD_BITS, WORD_BITS);
+            uint64_t open = OpenWord(map, y, w, bits);
+            open &= (bits < WORD_BITS) ? ((uint64_t)1 << bits) - 1 : ~(uint64_t)0;
+            int i = 0;
+            while(i < bits && success)
+            {
+                if(runStart < 0)
+                {
+                    uint64_t rest = open >> i;
+                    if(!rest)
+                    {
+                        break;
+                    }
+                    i += __builtin_ctzll(rest);
+                    runStart = w * WORD_BITS + i;
+                }
+                uint64_t walls = ~open >> i;
+                i += walls ? __builtin_ctzll(walls) : WORD_BITS - i;
+                if(i < bits) // Ended by a wall, otherwise the run goes on into the next word
+                {
+                    success = AddRun(&runs, &capacity, &count, runStart, w * WORD_BITS + i);
+                    runStart = -1;
+                }
+            }
+        }
+        if(runStart >= 0 && success)
+        {
+            success = AddRun(&runs, &capacity, &count, runStart, map->width);
+        }
+
+        // Join with the runs above that overlap, both rows are sorted by column
+        uint32_t above = (y > 0) ? rowFirst[y - 1] : rowFirst[y];
+        for(uint32_t run = rowFirst[y]; run < count && success; run++)
+        {
+            while(above < rowFirst[y] && runs[above].x1 <= runs[run].x0)
+            {
+                above++;
+            }
+            for(uint32_t ii = above; ii < rowFirst[y] && runs[ii].x0 < runs[run].x1; ii++)
+            {
+                Union(runs, run, ii);
+            }
+        }
+    }
+    if(!success)
+    {
+        free(runs);
+        return NULL;
+    }
+    rowFirst[map->height] = count;
+    (*runCount) = count;
+    return runs;
+}
+
+/*
+    Label the connected components of the map's open cells
+    Return FALSE if memory ran out
+*/
+static BOOL Build(LabelPlane * plane, const Map * map)
+{
+    memset(plane, 0, sizeof(LabelPlane));
+    uint32_t runCount = 0;
+    uint32_t * rowFirst = (uint32_t *)malloc(((size_t)map->height + 1) * sizeof(uint32_t));
+    LabelRun * runs = rowFirst ? ScanRuns(map, rowFirst, &runCount) : NULL;
+    if(!runs)
+    {
+        free(rowFirst);
+        return FALSE;
+    }
+
+    // Point every run at its root, then number the roots in scan order. Every root comes before
+    // the runs that point at it, so its parent already holds its label when they are reached
+    for(uint32_t run = 0; run < runCount; run++)
+    {
+        runs[run].parent = FindRoot(runs, run);
+    }
+    uint32_t count = 0;
+    for(uint32_t run = 0; run < runCount; run++)
+    {
+        runs[run].parent = (runs[run].parent == run) ? ++count : runs[runs[run].parent].parent;
+    }
+
+    size_t cells = (size_t)map->width * map->height;
+    plane->map      = map;
+    plane->revision = map->revision;
+    plane->width    = map->width;
+    plane->height   = map->height;
+    plane->count    = count;
+    plane->wide     = count >= UINT16_MAX;
+    plane->labels   = calloc(cells, plane->wide ? sizeof(uint32_t) : sizeof(uint16_t));
+    plane->sizes    = (uint32_t *)calloc((size_t)count + 1, sizeof(uint32_t));
+    BOOL success = plane->labels && plane->sizes;
+    for(int y = 0; y < map->height && success; y++)
+    {
+        for(uint32_t run = rowFirst[y]; run < rowFirst[y + 1]; run++)
+        {
+            for(int x = runs[run].x0; x < runs[run].x1; x++)
+            {
+                SetLabel(plane, (size_t)y * map->width + x, runs[run].parent);
+            }
+            plane->sizes[runs[run].parent] += runs[run].x1 - runs[run].x0;
+        }
+    }
+    free(runs);
+    free(rowFirst);
+    if(!success)
+    {
+        Destroy(plane);
+    }
+    return success;
+}
+
+/*
+    Return TRUE if the labels were built from this map as it is now
+*/
+static BOOL Current(const LabelPlane * plane, const Map * map)
+{
+    return plane->labels && plane->map == map && plane->revision == map->revision;
+}
+
+/*
+    Return the component of a cell, 0 for walls and cells outside the map
+*/
+static uint32_t Label(const LabelPlane * plane, int x, int y)
+{
+    if((unsigned int)x >= (unsigned int)plane->width || (unsigned int)y >= (unsigned int)plane->height)
+    {
+        return 0;
+    }
+    size_t index = (size_t)y * plane->width + x;
+    return plane->wide ? ((const uint32_t *)plane->labels)[index] : ((const uint16_t *)plane->labels)[index];
+}
+
+/*
+    Return TRUE if a path joins the two cells, without searching
+*/
+static BOOL Connected(const LabelPlane * plane, Node a, Node b)
+{
+    uint32_t label = Label(plane, a.x, a.y);
+    return label && label == Label(plane, b.x, b.y);
+}
+
+/*
+    Pick a random cell of a component, e.g. an endpoint reachable from a given start
+    Random cells are tried first, which takes a few tries when the component covers much of the map,
+    then the map is scanned from a random cell onwards
+    Return FALSE if the component has no cells
+*/
+static BOOL RandomCell(const LabelPlane * plane, uint32_t label, Node * cell)
+{
+    if(!label || label > plane->count)
+    {
+        return FALSE;
+    }
+    size_t cells = (size_t)plane->width * plane->height;
+    size_t index = 0;
+    for(int i = 0; i < LABELS_RANDOM_TRIES; i++)
+    {
+        index = ((size_t)Random() * ((size_t)UINT32_MAX + 1) + Random()) % cells;
+        if(Label(plane, index % plane->width, index / plane->width) == label)
+        {
+            cell->x = index % plane->width;
+            cell->y = index / plane->width;
+            return TRUE;
+        }
+    }
+    for(size_t i = 0; i < cells; i++, index = (index + 1) % cells)
+    {
+        if(Label(plane, index % plane->width, index / plane->width) == label)
+        {
+            cell->x = index % plane->width;
+            cell->y = index / plane->width;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+// Labels namespace struct, contains function pointers related to the LabelPlane struct
+const struct labels_namespace Labels_namespace =
+{
+    .Build = Build,
+    .Destroy = Destroy,
+    .Current = Current,
+    .Label = Label,
+    .Connected = Connected,
+    .RandomCell = RandomCell
+};
@@ -0,0 +1,39 @@
+#ifndef LABELS_H
+#define LABELS_H
+
+#include "common.h"
+#include "solver.h"
+
+#define LABELS_RANDOM_TRIES 64  // Random cells tried before RandomCell scans for a cell of the component
+
+/*
+    Connected components of the open (not WALL) cells of a map, found with one scan of the rows:
+    every run of open cells in a row is joined to the runs it touches in the row above
+    Two cells are connected exactly when they carry the same label, so reachability is one lookup
+    The plane belongs to one revision of the map, rebuild it after SetCell/SetRowWord edits
+*/
+typedef struct LabelPlane
+{
+    const Map * map;        // Map the labels were built from
+    uint64_t revision;      // Revision of the map when the labels were built
+    int width;
+    int height;
+    void * labels;          // Component of every cell, row-major, 0 for walls
+    BOOL wide;              // uint32_t labels instead of uint16_t
+    uint32_t count;         // Number of components, labelled 1 to count
+    uint32_t * sizes;       // Cells of every component, count + 1 entries
+} LabelPlane;
+
+typedef struct labels_namespace
+{
+    BOOL (* Build)(LabelPlane * plane, const Map * map);
+    void (* Destroy)(LabelPlane * plane);
+    BOOL (* Current)(const LabelPlane * plane, const Map * map);
+    uint32_t (* Label)(const LabelPlane * plane, int x, int y);
+    BOOL (* Connected)(const LabelPlane * plane, Node a, Node b);
+    BOOL (* RandomCell)(const LabelPlane * plane, uint32_t label, Node * cell);
+} labels_namespace;
+
+extern const struct labels_namespace Labels_namespace;
+
+#endif // LABELS_H
@@ -0,0 +1,118 @@
+#define _GNU_SOURCE
+
+#include "pacer.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+/*
+    Return monotonic time in milliseconds
+*/
+static double Now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+/*
+    Sleep for the given number of milliseconds, nothing if it is not positive
+*/
+static void Wait(double milliseconds)
+{
+    if(milliseconds <= 0)
+    {
+        return;
+    }
+#ifdef _WIN32
+    Sleep((DWORD)milliseconds);
+#else
+    struct timespec t;
+    t.tv_sec    = (time_t)(milliseconds / 1000);
+    t.tv_nsec   = (long)((milliseconds - t.tv_sec * 1000.0) * 1000000.0);
+    nanosleep(&t, NULL);
+#endif
+}
+
+/*
+    Set up a pacer and read its options from the command line:
+    -p <steps>  steps per frame, plays the algorithm back at a fixed speed
+    -t <ms>     milliseconds of work per frame (default: the whole frame), used without -p
+    fps     = frames per second at most
+    draw    = draws one frame
+    context = passed to draw
+    Return the index of the first argument that is not a pacer option
+*/
+static int Init(Pacer * pacer, int argc, char * argv[], int fps, FrameFunction draw, void * context)
+{
+    memset(pacer, 0, sizeof(Pacer));
+    pacer->draw         = draw;
+    pacer->context      = context;
+    pacer->frameTime    = 1000.0 / (fps > 0 ? fps : 1);
+    pacer->workTime     = pacer->frameTime;
+    int i = 1;
+    for(; i + 1 < argc; i += 2)
+    {
+        if(strcmp(argv[i], "-p") == 0)
+        {
+            pacer->stepsPerFrame = __max(atoi(argv[i + 1]), 0);
+        }
+        else if(strcmp(argv[i], "-t") == 0)
+        {
+            pacer->workTime = __max(atof(argv[i + 1]), 0.0);
+        }
+        else
+        {
+            break;
+        }
+    }
+    pacer->frameStart   = Now();
+    pacer->workStart    = pacer->frameStart;
+    return i;
+}
+
+/*
+    Wait for the next frame time and draw it
+    Return FALSE if draw asked to stop
+*/
+static BOOL Present(Pacer * pacer)
+{
+    Wait(pacer->frameStart + pacer->frameTime - Now());
+    pacer->frameStart = Now();
+    BOOL running = pacer->draw(pacer->context);
+    pacer->workStart = Now();
+    pacer->steps = 0;
+    pacer->frames++;
+    return running;
+}
+
+/*
+    Report one step of the algorithm, drawing a frame once the frame's budget is used up
+    Return FALSE if draw asked to stop
+*/
+static BOOL Step(Pacer * pacer)
+{
+    pacer->steps++;
+    if(pacer->stepsPerFrame > 0)
+    {
+        return (pacer->steps < pacer->stepsPerFrame) ? TRUE : Present(pacer);
+    }
+    if(pacer->steps % PACER_CHECK_STEPS || Now() - pacer->workStart < pacer->workTime)
+    {
+        return TRUE;
+    }
+    return Present(pacer);
+}
+
+// Pacer namespace struct, contains function pointers related to the Pacer struct
+const struct pacer_namespace Pacer_namespace =
+{
+    .Init = Init,
+    .Step = Step,
+    .Present = Present
+};
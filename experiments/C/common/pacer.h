@@ -0,0 +1,42 @@
+#ifndef PACER_H
+#define PACER_H
+
+#include "common.h"
+
+#define PACER_CHECK_STEPS   64  // Steps between clock reads when only the time budget ends a frame
+
+/*
+    Draws one frame, return FALSE to stop (e.g. the window was closed)
+*/
+typedef BOOL (* FrameFunction)(void * context);
+
+/*
+    Decouples a visualised algorithm from its drawing. The algorithm reports every step it takes and
+    carries on at full speed; a frame is drawn once a frame's budget of work is done, at most at the
+    frame rate, showing everything that changed since the last one. The budget is a number of steps,
+    which plays the algorithm back at a fixed speed, or milliseconds of work, which shows it as fast
+    as it runs. Either way playback no longer depends on how long a single step or frame takes
+*/
+typedef struct Pacer
+{
+    FrameFunction draw;
+    void * context;         // Passed to draw
+    double frameTime;       // Milliseconds from one frame to the next
+    double workTime;        // Milliseconds of work per frame, used when stepsPerFrame is 0
+    int stepsPerFrame;      // Steps per frame, 0 to end frames on workTime instead
+    int steps;              // Steps since the last frame
+    double frameStart;      // When the last frame was drawn
+    double workStart;       // When the last frame finished drawing
+    size_t frames;          // Frames drawn
+} Pacer;
+
+typedef struct pacer_namespace
+{
+    int (* Init)(Pacer * pacer, int argc, char * argv[], int fps, FrameFunction draw, void * context);
+    BOOL (* Step)(Pacer * pacer);
+    BOOL (* Present)(Pacer * pacer);
+} pacer_namespace;
+
+extern const struct pacer_namespace Pacer_namespace;
+
+#endif // PACER_H
@@ -0,0 +1,311 @@
+#include "planner.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    Return TRUE if a path can go through the cell: inside the map and not a WALL
+*/
+static inline BOOL Walkable(const Map * map, int x, int y)
+{
+    return MapInBounds(map, x, y) && MapGetUnchecked(map, x, y) != WALL;
+}
+
+/*
+    Heap key of a cell: smallest estimated path length through it first, then the cell
+    closest to the start. Only valid while the cell is inconsistent (g != rhs)
+*/
+static inline uint64_t CellKey(const Planner * planner, uint32_t cell)
+{
+    int x = cell % planner->map->width;
+    int y = cell / planner->map->width;
+    uint32_t best = __min(planner->g[cell], planner->rhs[cell]);
+    uint32_t heuristic = (uint32_t)(abs(x - planner->end.x) + abs(y - planner->end.y));
+    if(best == PLANNER_UNREACHED)
+    {
+        return UINT64_MAX;
+    }
+    return ((uint64_t)(best + heuristic) << 32) | best;
+}
+
+/*
+    Recompute the lookahead of a cell from its neighbours and queue it if it became inconsistent
+    Any older queue entry of the cell is left behind and skipped when popped
+    Return FALSE if the queue could not grow
+*/
+static BOOL UpdateCell(Planner * planner, int x, int y)
+{
+    static const int offsets[4][2] = {{0, -1}, {0, 1}, {1, 0}, {-1, 0}}; // N, S, E, W
+    Map * map = planner->map;
+    uint32_t cell = (uint32_t)y * map->width + x;
+    uint32_t rhs = PLANNER_UNREACHED;
+    if(!Walkable(map, x, y))
+    {
+        rhs = PLANNER_UNREACHED;
+    }
+    else if(x == planner->start.x && y == planner->start.y)
+    {
+        rhs = 0;
+    }
+    else
+    {
+        for(int i = 0; i < 4; i++)
+        {
+            int nx = x + offsets[i][0];
+            int ny = y + offsets[i][1];
+            if(Walkable(map, nx, ny))
+            {
+                uint32_t g = planner->g[(size_t)ny * map->width + nx];
+                rhs = (g != PLANNER_UNREACHED && g + 1 < rhs) ? g + 1 : rhs;
+            }
+        }
+    }
+    planner->rhs[cell] = rhs;
+    if(planner->g[cell] != rhs)
+    {
+        return Heap_namespace.Push(&planner->heap, CellKey(planner, cell), cell);
+    }
+    return TRUE;
+}
+
+/*
+    Update a cell and its four neighbours, whose lookahead depends on it
+*/
+static BOOL UpdateAround(Planner * planner, int x, int y)
+{
+    BOOL running = UpdateCell(planner, x, y);
+    running = (y > 0 ? UpdateCell(planner, x, y - 1) : TRUE) && running;
+    running = (y + 1 < planner->map->height ? UpdateCell(planner, x, y + 1) : TRUE) && running;
+    running = (x + 1 < planner->map->width ? UpdateCell(planner, x + 1, y) : TRUE) && running;
+    running = (x > 0 ? UpdateCell(planner, x - 1, y) : TRUE) && running;
+    return running;
+}
+
+/*
+    Forget the search state and queue the start again, for a new map revision
+*/
+static BOOL Restart(Planner * planner)
+{
+    size_t cells = (size_t)planner->map->width * planner->map->height;
+    memset(planner->g, 0xFF, cells * sizeof(uint32_t));
+    memset(planner->rhs, 0xFF, cells * sizeof(uint32_t));
+    Heap_namespace.Clear(&planner->heap);
+    planner->revision   = planner->map->revision;
+    planner->dirty      = TRUE;
+    return UpdateCell(planner, planner->start.x, planner->start.y);
+}
+
+/*
+    Rebuild the queue from the inconsistent cells once stale entries outnumber the cells,
+    so a long run of edits does not grow it without bound
+*/
+static BOOL CompactQueue(Planner * planner)
+{
+    size_t cells = (size_t)planner->map->width * planner->map->height;
+    if(Heap_namespace.Size(&planner->heap) <= cells)
+    {
+        return TRUE;
+    }
+    Heap_namespace.Clear(&planner->heap);
+    BOOL running = TRUE;
+    for(uint32_t cell = 0; cell < cells && running; cell++)
+    {
+        if(planner->g[cell] != planner->rhs[cell])
+        {
+            running = Heap_namespace.Push(&planner->heap, CellKey(planner, cell), cell);
+        }
+    }
+    return running;
+}
+
+/*
+    Expand inconsistent cells in key order until the end cell is consistent and no queued cell
+    could still lower its distance
+    expanded = receives the number of cells expanded
+    Return FALSE if the queue could not grow
+*/
+static BOOL ComputeShortestPath(Planner * planner, size_t * expanded)
+{
+    static const int offsets[4][2] = {{0, -1}, {0, 1}, {1, 0}, {-1, 0}}; // N, S, E, W
+    Map * map = planner->map;
+    uint32_t endCell = (uint32_t)planner->end.y * map->width + planner->end.x;
+    BOOL running = CompactQueue(planner);
+    HeapEntry top;
+    while(running && Heap_namespace.Peek(&planner->heap, &top))
+    {
+        uint32_t cell = top.value;
+        if(planner->g[cell] == planner->rhs[cell] || top.key != CellKey(planner, cell))
+        {
+            Heap_namespace.Pop(&planner->heap, &top);
+            continue; // Stale, the cell became consistent or was queued again with another key
+        }
+        if(top.key >= CellKey(planner, endCell) && planner->g[endCell] == planner->rhs[endCell])
+        {
+            break;
+        }
+        Heap_namespace.Pop(&planner->heap, &top);
+        (*expanded)++;
+
+        int x = cell % map->width;
+        int y = cell / map->width;
+        if(planner->g[cell] > planner->rhs[cell])
+        {
+            // Found a shorter path to the cell, pass it on to the neighbours
+            planner->g[cell] = planner->rhs[cell];
+        }
+        else
+        {
+            // The path the cell's distance relied on is gone, recompute it and the neighbours
+            planner->g[cell] = PLANNER_UNREACHED;
+            running = UpdateCell(planner, x, y);
+        }
+        for(int i = 0; i < 4 && running; i++)
+        {
+            int nx = x + offsets[i][0];
+            int ny = y + offsets[i][1];
+            if(MapInBounds(map, nx, ny))
+            {
+                running = UpdateCell(planner, nx, ny);
+            }
+        }
+    }
+    return running;
+}
+
+/*
+    Free the search state. The map is left as it is
+*/
+static void Destroy(Planner * planner)
+{
+    free(planner->g);
+    free(planner->rhs);
+    Heap_namespace.Destroy(&planner->heap);
+    planner->g      = NULL;
+    planner->rhs    = NULL;
+}
+
+/*
+    Start planning between two cells of a map. Nothing is searched until the first Path call
+    Return FALSE if memory could not be allocated or a cell is outside the map
+*/
+static BOOL Init(Planner * planner, Map * map, Node start, Node end)
+{
+    size_t cells = (size_t)map->width * map->height;
+    planner->map    = map;
+    planner->start  = start;
+    planner->end    = end;
+    planner->g      = (uint32_t *)malloc(cells * sizeof(uint32_t));
+    planner->rhs    = (uint32_t *)malloc(cells * sizeof(uint32_t));
+    BOOL running = Heap_namespace.Init(&planner->heap, map->width + map->height);
+    running = running && planner->g && planner->rhs && MapInBounds(map, start.x, start.y) && MapInBounds(map, end.x, end.y);
+    if(!running || !Restart(planner))
+    {
+        Destroy(planner);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+    Apply cell edits to the map with SetCell and queue the cells whose distance may change
+    The path is repaired by the next Path call, so a batch of edits is repaired at once
+    If the map was edited some other way since the last call, the next Path call searches from scratch
+    Return FALSE if the queue could not grow, the next Path call then searches from scratch
+*/
+static BOOL Edit(Planner * planner, const PlannerEdit * edits, int count)
+{
+    BOOL current = (planner->map->revision == planner->revision);
+    BOOL running = TRUE;
+    for(int i = 0; i < count; i++)
+    {
+        if(!MapInBounds(planner->map, edits[i].x, edits[i].y))
+        {
+            continue;
+        }
+        BOOL walkable = Walkable(planner->map, edits[i].x, edits[i].y);
+        Map_namespace.SetCell(planner->map, edits[i].x, edits[i].y, edits[i].value);
+        if(current && running && walkable != Walkable(planner->map, edits[i].x, edits[i].y))
+        {
+            running = UpdateAround(planner, edits[i].x, edits[i].y);
+        }
+    }
+    planner->dirty = TRUE;
+    if(current && running)
+    {
+        planner->revision = planner->map->revision;
+    }
+    return running;
+}
+
+/*
+    Repair the search after the edits since the last call, then return the current shortest path
+    path     = receives the cells from start to end if the path fits, can be NULL to only get the length
+    capacity = number of nodes path can hold
+    stats    = receives the work done by the repair, can be NULL
+    Return the number of cells of the path including both ends, or 0 if out of memory or unreachable
+*/
+static int Path(Planner * planner, Node * path, int capacity, SolverStats * stats)
+{
+    static const int offsets[4][2] = {{0, -1}, {0, 1}, {1, 0}, {-1, 0}}; // N, S, E, W
+    Map * map = planner->map;
+    size_t expanded = 0;
+    BOOL running = TRUE;
+    if(map->revision != planner->revision)
+    {
+        running = Restart(planner);
+    }
+    if(running && planner->dirty)
+    {
+        running = ComputeShortestPath(planner, &expanded);
+        planner->dirty = !running;
+    }
+    if(stats)
+    {
+        stats->expanded = expanded;
+    }
+    uint32_t distance = planner->g[(size_t)planner->end.y * map->width + planner->end.x];
+    if(!running || distance == PLANNER_UNREACHED)
+    {
+        if(!running)
+        {
+            planner->revision = 0; // No map has revision 0, so the next call searches from scratch
+        }
+        return 0;
+    }
+
+    // Walk back from the end, always to the neighbour closest to the start, preferring N, S, E, W
+    int length = (int)distance + 1;
+    int x = planner->end.x;
+    int y = planner->end.y;
+    for(int i = length - 1; i >= 0 && path && length <= capacity; i--)
+    {
+        path[i].x = x;
+        path[i].y = y;
+        int bestX = x;
+        int bestY = y;
+        uint32_t best = PLANNER_UNREACHED;
+        for(int ii = 0; ii < 4; ii++)
+        {
+            int nx = x + offsets[ii][0];
+            int ny = y + offsets[ii][1];
+            if(Walkable(map, nx, ny) && planner->g[(size_t)ny * map->width + nx] < best)
+            {
+                best = planner->g[(size_t)ny * map->width + nx];
+                bestX = nx;
+                bestY = ny;
+            }
+        }
+        x = bestX;
+        y = bestY;
+    }
+    return length;
+}
+
+// Planner namespace struct, contains function pointers related to the Planner struct
+const struct planner_namespace Planner_namespace =
+{
+    .Init = Init,
+    .Destroy = Destroy,
+    .Edit = Edit,
+    .Path = Path
+};
@@ -0,0 +1,49 @@
+#ifndef PLANNER_H
+#define PLANNER_H
+
+#include "common.h"
+#include "heap.h"
+#include "solver.h"
+
+#define PLANNER_UNREACHED   UINT32_MAX  // Distance of cells with no known path from the start
+
+/*
+    One cell edit applied through a planner
+*/
+typedef struct PlannerEdit
+{
+    int x;
+    int y;
+    unsigned int value; // WALL, or FREE to open the cell
+} PlannerEdit;
+
+/*
+    Incremental shortest path search between two fixed cells of a map that gets edited (LPA*)
+    The search state is kept between calls. After an edit only cells whose distance actually
+    changed are expanded again, so repairing the path costs about as much as the change, not the map
+    g   = distance from start of every cell as of the last search, PLANNER_UNREACHED if none
+    rhs = one-step lookahead, the best g of a neighbour plus one. Cells where g != rhs are queued
+*/
+typedef struct Planner
+{
+    Map * map;
+    Node start;
+    Node end;
+    uint32_t * g;
+    uint32_t * rhs;
+    Heap heap;          // Inconsistent cells by key, stale entries are skipped when popped
+    uint64_t revision;  // Map revision the state matches, other edits of the map restart the search
+    BOOL dirty;         // Edits were applied since the last search
+} Planner;
+
+typedef struct planner_namespace
+{
+    BOOL (* Init)(Planner * planner, Map * map, Node start, Node end);
+    void (* Destroy)(Planner * planner);
+    BOOL (* Edit)(Planner * planner, const PlannerEdit * edits, int count);
+    int (* Path)(Planner * planner, Node * path, int capacity, SolverStats * stats);
+} planner_namespace;
+
+extern const struct planner_namespace Planner_namespace;
+
+#endif // PLANNER_H
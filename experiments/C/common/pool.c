@@ -0,0 +1,180 @@
+#include "pool.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+// Set while the thread runs a task of a pool that has other threads working next to it
+static __thread BOOL sharingCores = FALSE;
+
+/*
+    Run task indices until there are none left
+*/
+static void Drain(Pool * pool, int thread)
+{
+    BOOL sharing = sharingCores;
+    sharingCores = sharing || pool->threadCount > 1;
+    int index;
+    while((index = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED)) < pool->count)
+    {
+        pool->task(pool->context, index, thread);
+    }
+    sharingCores = sharing;
+}
+
+/*
+    Worker thread: wait for a task, help drain it, report back, repeat until the pool stops
+*/
+static void * WorkerMain(void * argument)
+{
+    PoolWorker * worker = (PoolWorker *)argument;
+    Pool * pool = worker->pool;
+    int generation = 0;
+    while(TRUE)
+    {
+        pthread_mutex_lock(&pool->lock);
+        while(pool->generation == generation && !pool->stop)
+        {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if(pool->stop)
+        {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        generation = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        Drain(pool, worker->thread);
+
+        pthread_mutex_lock(&pool->lock);
+        if(--pool->busy == 0)
+        {
+            pthread_cond_signal(&pool->done);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+/*
+    Start the worker threads
+    threadCount = number of threads including the caller, 0 for one per core
+    Return FALSE if no memory. If only some threads could be started the pool runs with fewer
+*/
+static BOOL Init(Pool * pool, int threadCount)
+{
+    if(threadCount < 1)
+    {
+        threadCount = Pool_namespace.CoreCount();
+    }
+    pool->threads       = (pthread_t *)malloc(threadCount * sizeof(pthread_t));
+    pool->workers       = (PoolWorker *)malloc(threadCount * sizeof(PoolWorker));
+    pool->threadCount   = 1;
+    pool->task          = NULL;
+    pool->context       = NULL;
+    pool->count         = 0;
+    pool->next          = 0;
+    pool->busy          = 0;
+    pool->generation    = 0;
+    pool->stop          = FALSE;
+    if(!pool->threads || !pool->workers)
+    {
+        free(pool->threads);
+        free(pool->workers);
+        return FALSE;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    // Thread 0 is the caller
+    pool->workers[0].pool   = pool;
+    pool->workers[0].thread = 0;
+    for(int i = 1; i < threadCount; i++)
+    {
+        pool->workers[i].pool   = pool;
+        pool->workers[i].thread = i;
+        if(pthread_create(&pool->threads[i], NULL, WorkerMain, &pool->workers[i]) != 0)
+        {
+            break;
+        }
+        pool->threadCount++;
+    }
+    return TRUE;
+}
+
+/*
+    Stop and join the worker threads
+*/
+static void Destroy(Pool * pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = TRUE;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    for(int i = 1; i < pool->threadCount; i++)
+    {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    free(pool->threads);
+    free(pool->workers);
+    pool->threads       = NULL;
+    pool->workers       = NULL;
+    pool->threadCount   = 0;
+}
+
+/*
+    Run a task for every index from 0 to count - 1 on all threads of the pool, and wait for it to finish
+    The order in which indices run is undefined
+*/
+static void Run(Pool * pool, int count, PoolTask task, void * context)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->task      = task;
+    pool->context   = context;
+    pool->count     = count;
+    pool->next      = 0;
+    pool->busy      = pool->threadCount - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    Drain(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while(pool->busy > 0)
+    {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/*
+    Return TRUE if the calling thread is running a task of a pool of more than one thread
+    Tasks use it to avoid starting more threads of their own on cores the pool already keeps busy
+*/
+static BOOL InTask(void)
+{
+    return sharingCores;
+}
+
+/*
+    Return the number of online processor cores, at least 1
+*/
+static int CoreCount(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+// Pool namespace struct, contains function pointers related to the Pool struct
+const struct pool_namespace Pool_namespace =
+{
+    .Init = Init,
+    .Destroy = Destroy,
+    .Run = Run,
+    .InTask = InTask,
+    .CoreCount = CoreCount
+};
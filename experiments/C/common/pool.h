@@ -0,0 +1,55 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include "common.h"
+
+#include <pthread.h>
+
+/*
+    Task run by the pool once per index
+    context = pointer given to Run
+    index   = index of the work item, 0 to count - 1
+    thread  = index of the thread running it, 0 to threadCount - 1, for per-thread scratch
+*/
+typedef void (* PoolTask)(void * context, int index, int thread);
+
+typedef struct PoolWorker
+{
+    struct Pool * pool;
+    int thread;
+} PoolWorker;
+
+/*
+    Fixed set of worker threads that run a task over a range of indices
+    The calling thread works as thread 0, so a pool of one thread starts no threads at all
+    Indices are handed out one at a time, so uneven items (maps of different sizes) balance out
+*/
+typedef struct Pool
+{
+    int threadCount;
+    pthread_t * threads;
+    PoolWorker * workers;
+    pthread_mutex_t lock;
+    pthread_cond_t start;   // Signalled when a new task is posted or the pool stops
+    pthread_cond_t done;    // Signalled when the last worker finishes a task
+    PoolTask task;
+    void * context;
+    int count;              // Number of indices of the current task
+    int next;               // Next index to hand out
+    int busy;               // Workers still running the current task
+    int generation;         // Bumped for every task, so workers do not run one twice
+    BOOL stop;
+} Pool;
+
+typedef struct pool_namespace
+{
+    BOOL (* Init)(Pool * pool, int threadCount);
+    void (* Destroy)(Pool * pool);
+    void (* Run)(Pool * pool, int count, PoolTask task, void * context);
+    BOOL (* InTask)(void);
+    int (* CoreCount)(void);
+} pool_namespace;
+
+extern const struct pool_namespace Pool_namespace;
+
+#endif // POOL_H
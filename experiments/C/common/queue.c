@@ -0,0 +1,155 @@
+#include "queue.h"
+#include "arena.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    Make sure the queue can hold at least the given number of elements without growing
+    Elements are moved to the front of the new buffer, in order
+    Return FALSE if memory could not be allocated, the queue is left untouched
+*/
+static BOOL Reserve(Queue * queue, size_t capacity)
+{
+    if(capacity <= queue->capacity)
+    {
+        return TRUE;
+    }
+    size_t size = 1;
+    while(size < capacity)
+    {
+        size <<= 1;
+    }
+    // Fall back to malloc once the arena is exhausted
+    char * data = queue->arena ? (char *)Arena_namespace.Alloc(queue->arena, size * queue->elementSize) : NULL;
+    BOOL owned = (data == NULL);
+    data = owned ? (char *)malloc(size * queue->elementSize) : data;
+    if(!data)
+    {
+        return FALSE;
+    }
+
+    // Unwrap: copy the part up to the end of the buffer, then the wrapped-around part
+    size_t first = queue->capacity - queue->head;
+    first = (first < queue->count) ? first : queue->count;
+    if(queue->count)
+    {
+        memcpy(data, queue->data + queue->head * queue->elementSize, first * queue->elementSize);
+        memcpy(data + first * queue->elementSize, queue->data, (queue->count - first) * queue->elementSize);
+    }
+    if(queue->owned)
+    {
+        free(queue->data);
+    }
+    queue->data     = data;
+    queue->owned    = owned;
+    queue->capacity = size;
+    queue->head     = 0;
+    return TRUE;
+}
+
+/*
+    Initialise an empty queue that allocates from an arena
+    elementSize = size of one element in bytes
+    capacity    = number of elements to reserve up front (can be 0)
+    arena       = arena to allocate from, NULL to use malloc. Buffers that do not fit in the arena are malloced
+*/
+static BOOL InitArena(Queue * queue, size_t elementSize, size_t capacity, Arena * arena)
+{
+    queue->data         = NULL;
+    queue->elementSize  = elementSize;
+    queue->capacity     = 0;
+    queue->head         = 0;
+    queue->count        = 0;
+    queue->arena        = arena;
+    queue->owned        = FALSE;
+    return Reserve(queue, capacity ? capacity : 16);
+}
+
+/*
+    Initialise an empty queue
+    elementSize = size of one element in bytes
+    capacity    = number of elements to reserve up front (can be 0)
+*/
+static BOOL Init(Queue * queue, size_t elementSize, size_t capacity)
+{
+    return InitArena(queue, elementSize, capacity, NULL);
+}
+
+/*
+    Free the queue memory. Arena memory is left for the arena owner to reset
+*/
+static void Destroy(Queue * queue)
+{
+    if(queue->owned)
+    {
+        free(queue->data);
+    }
+    queue->data     = NULL;
+    queue->owned    = FALSE;
+    queue->capacity = 0;
+    queue->head     = 0;
+    queue->count    = 0;
+}
+
+/*
+    Add an element to the back of the queue, doubling the capacity if it is full
+    Return FALSE if the queue had to grow and memory could not be allocated
+*/
+static BOOL Push(Queue * queue, const void * element)
+{
+    if(queue->count == queue->capacity && !Reserve(queue, queue->capacity * 2))
+    {
+        return FALSE;
+    }
+    size_t slot = (queue->head + queue->count) & (queue->capacity - 1);
+    memcpy(queue->data + slot * queue->elementSize, element, queue->elementSize);
+    queue->count++;
+    return TRUE;
+}
+
+/*
+    Remove the element at the front of the queue and copy it into element
+    Return FALSE if the queue is empty
+*/
+static BOOL Pop(Queue * queue, void * element)
+{
+    if(!queue->count)
+    {
+        return FALSE;
+    }
+    memcpy(element, queue->data + queue->head * queue->elementSize, queue->elementSize);
+    queue->head = (queue->head + 1) & (queue->capacity - 1);
+    queue->count--;
+    return TRUE;
+}
+
+/*
+    Remove all elements, keeping the memory for reuse
+*/
+static void Clear(Queue * queue)
+{
+    queue->head  = 0;
+    queue->count = 0;
+}
+
+/*
+    Return the number of queued elements
+*/
+static size_t Size(Queue * queue)
+{
+    return queue->count;
+}
+
+// Queue namespace struct, contains function pointers related to the Queue struct
+const struct queue_namespace Queue_namespace =
+{
+    .Init = Init,
+    .InitArena = InitArena,
+    .Destroy = Destroy,
+    .Reserve = Reserve,
+    .Push = Push,
+    .Pop = Pop,
+    .Clear = Clear,
+    .Size = Size
+};
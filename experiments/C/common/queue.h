@@ -0,0 +1,36 @@
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include "common.h"
+
+/*
+    Growable FIFO ring buffer of fixed-size elements
+    Capacity is always a power of two and doubles when full. Popped slots are reused,
+    so memory is bounded by the largest number of elements queued at once
+*/
+typedef struct Queue
+{
+    char * data;
+    size_t elementSize; // Size of one element in bytes
+    size_t capacity;    // Number of elements that fit before growing
+    size_t head;        // Slot of the first element
+    size_t count;       // Number of queued elements
+    struct Arena * arena; // Arena to allocate the buffer from, NULL for malloc
+    BOOL owned;         // The buffer was malloced and is freed by the queue
+} Queue;
+
+typedef struct queue_namespace
+{
+    BOOL (* Init)(Queue * queue, size_t elementSize, size_t capacity);
+    BOOL (* InitArena)(Queue * queue, size_t elementSize, size_t capacity, struct Arena * arena);
+    void (* Destroy)(Queue * queue);
+    BOOL (* Reserve)(Queue * queue, size_t capacity);
+    BOOL (* Push)(Queue * queue, const void * element);
+    BOOL (* Pop)(Queue * queue, void * element);
+    void (* Clear)(Queue * queue);
+    size_t (* Size)(Queue * queue);
+} queue_namespace;
+
+extern const struct queue_namespace Queue_namespace;
+
+#endif // QUEUE_H
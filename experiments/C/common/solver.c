@@ -0,0 +1,1878 @@
+#include "solver.h"
+#include "arena.h"
+#include "heap.h"
+#include "pool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define PARALLEL_CHUNK          1024    // Frontier cells (or cells of bottom-up rows) per task index
+#define PARALLEL_MIN_FRONTIER   4096    // Smaller levels are expanded on the calling thread
+#define PARALLEL_ALPHA          14      // Go bottom up when frontier edges > unvisited cells / ALPHA
+#define PARALLEL_BETA           24      // Go back top down when the frontier < cells / BETA
+#define DIAL_BUCKETS            (MAP_MAX_COST + 1) // Queued costs never run further ahead than the costliest step
+#define DIAL_EMPTY              UINT32_MAX
+
+/*
+    Mark every FREE neighbour of a node with the given distance and add it to the queue
+    Cells are marked when queued, so every cell is queued at most once
+    Return FALSE if the queue could not grow
+    pushed = set to TRUE if any neighbour was queued
+*/
+static BOOL ExpandNode(Map * map, Queue * queue, Node node, unsigned int distance, BOOL * pushed)
+{
+    static const int offsets[4][3] = {{cNorth, 0, -1}, {cSouth, 0, 1}, {cEast, 1, 0}, {cWest, -1, 0}};
+    int freeNeighbours = MapFreeNeighbours(map, node.x, node.y);
+    for(int i = 0; i < 4; i++)
+    {
+        if(freeNeighbours & offsets[i][0])
+        {
+            Node next = {node.x + offsets[i][1], node.y + offsets[i][2]};
+            MapSetUnchecked(map, next.x, next.y, distance);
+            if(!Queue_namespace.Push(queue, &next))
+            {
+                return FALSE;
+            }
+            (*pushed) = TRUE;
+        }
+    }
+    return TRUE;
+}
+
+/*
+    Allocate zeroed scratch memory from an arena, falling back to calloc once it is exhausted
+    arena = arena to allocate from, NULL for calloc
+    owned = set to TRUE if the memory was calloced and must be freed
+*/
+static void * ScratchAllocArena(Arena * arena, size_t size, BOOL * owned)
+{
+    void * memory = arena ? Arena_namespace.Alloc(arena, size) : NULL;
+    (*owned) = (memory == NULL);
+    if(memory)
+    {
+        return memset(memory, 0, size);
+    }
+    return calloc(1, size);
+}
+
+/*
+    Breadth first distances of a search, counted from 1 at the start, 0 for cells not reached
+    Cells are 16 bits when every distance fits, 32 bits otherwise
+*/
+typedef struct DistanceBuffer
+{
+    void * data;
+    BOOL wide;  // uint32_t cells instead of uint16_t
+    BOOL owned; // Calloced instead of taken from an arena
+} DistanceBuffer;
+
+static inline uint32_t GetDistance(const DistanceBuffer * distances, size_t index)
+{
+    return distances->wide ? ((const uint32_t *)distances->data)[index] : ((const uint16_t *)distances->data)[index];
+}
+
+static inline void SetDistance(DistanceBuffer * distances, size_t index, uint32_t value)
+{
+    if(distances->wide)
+    {
+        ((uint32_t *)distances->data)[index] = value;
+    }
+    else
+    {
+        ((uint16_t *)distances->data)[index] = (uint16_t)value;
+    }
+}
+
+/*
+    Return TRUE if a search can step on the cell: inside the map and not a WALL
+*/
+static inline BOOL CellWalkable(const Map * map, int x, int y)
+{
+    return MapInBounds(map, x, y) && MapGetUnchecked(map, x, y) != WALL;
+}
+
+/*
+    Flood the map breadth first from start, writing the distances into a zeroed buffer
+    The map is only read
+    end   = cell to stop at, NULL to flood every reachable cell
+    arena = arena for the queue, NULL for malloc
+    stats = receives the work done, can be NULL
+    Return FALSE if memory ran out or end cannot be reached from start
+*/
+static BOOL Flood(const Map * map, Node start, const Node * end, DistanceBuffer * distances, Arena * arena, SolverStats * stats)
+{
+    static const int offsets[4][2] = {{0, -1}, {0, 1}, {1, 0}, {-1, 0}}; // N, S, E, W
+    if(!CellWalkable(map, start.x, start.y) || (end && !CellWalkable(map, end->x, end->y)))
+    {
+        return FALSE;
+    }
+    Queue queue;
+    BOOL running = Queue_namespace.InitArena(&queue, sizeof(Node), map->width + map->height, arena)
+        && Queue_namespace.Push(&queue, &start);
+    SetDistance(distances, (size_t)start.y * map->width + start.x, 1);
+
+    // Walk away from the start location, remembering the distance to it
+    BOOL found = end && (start.x == end->x && start.y == end->y);
+    size_t expanded = 0;
+    Node node;
+    while(running && !found && Queue_namespace.Pop(&queue, &node))
+    {
+        expanded++;
+        uint32_t distance = GetDistance(distances, (size_t)node.y * map->width + node.x) + 1;
+        for(int i = 0; i < 4 && running && !found; i++)
+        {
+            Node next = {node.x + offsets[i][0], node.y + offsets[i][1]};
+            size_t index = (size_t)next.y * map->width + next.x;
+            if(CellWalkable(map, next.x, next.y) && !GetDistance(distances, index))
+            {
+                SetDistance(distances, index, distance);
+                found = end && (next.x == end->x && next.y == end->y);
+                running = Queue_namespace.Push(&queue, &next);
+            }
+        }
+    }
+    Queue_namespace.Destroy(&queue);
+    if(stats)
+    {
+        stats->expanded = expanded;
+    }
+    return running && (found || !end);
+}
+
+/*
+    Allocate a distance buffer sized for the map and flood it from start until end is reached
+    The buffer is allocated from the arena and left for the caller to free (when owned) or reset
+    distances = receives the distances, data is NULL if it could not be allocated
+    arena     = arena for the scratch memory, NULL for malloc
+    stats     = receives the work done, can be NULL
+    Return FALSE if memory ran out or end cannot be reached from start
+*/
+static BOOL FloodDistances(const Map * map, Node start, Node end, DistanceBuffer * distances, Arena * arena, SolverStats * stats)
+{
+    size_t cells = (size_t)map->width * map->height;
+    distances->wide = (cells >= UINT16_MAX);
+    distances->data = ScratchAllocArena(arena, cells * (distances->wide ? sizeof(uint32_t) : sizeof(uint16_t)), &distances->owned);
+    return distances->data && Flood(map, start, &end, distances, arena, stats);
+}
+
+/*
+    Flood the whole map breadth first from a source cell without writing to the map
+    distance = receives the distance from source plus one for every cell, 0 where it cannot be reached.
+               width * height entries, in row-major order
+    arena    = arena for the scratch memory, reset before returning. NULL for malloc
+    Return FALSE if memory ran out or the source is not walkable
+*/
+static BOOL FloodFill(const Map * map, Node source, uint32_t * distance, Arena * arena)
+{
+    if(!MapInBounds(map, source.x, source.y))
+    {
+        return FALSE;
+    }
+    ArenaMark mark = arena ? Arena_namespace.Mark(arena) : 0;
+    DistanceBuffer distances = {distance, TRUE, FALSE};
+    memset(distance, 0, (size_t)map->width * map->height * sizeof(uint32_t));
+    BOOL filled = Flood(map, source, NULL, &distances, arena, NULL);
+    if(arena)
+    {
+        Arena_namespace.Reset(arena, mark);
+    }
+    return filled;
+}
+
+/*
+    Walk back from end to the start of a flood, always to the neighbour one closer, preferring N, S, E, W
+    path   = receives the cells from start to end, can be NULL
+    output = map to mark the cells on with PATH, can be NULL
+    Return the number of cells of the path
+*/
+static int TracePath(const Map * map, const DistanceBuffer * distances, Node end, Node * path, Map * output)
+{
+    int x = end.x;
+    int y = end.y;
+    uint32_t length = GetDistance(distances, (size_t)y * map->width + x);
+    for(uint32_t distance = length; distance > 0; distance--)
+    {
+        if(path)
+        {
+            path[distance - 1].x = x;
+            path[distance - 1].y = y;
+        }
+        if(output)
+        {
+            MapSetUnchecked(output, x, y, PATH);
+        }
+        // North
+        if(y > 0 && GetDistance(distances, (size_t)(y - 1) * map->width + x) == distance - 1)
+        {
+            y--;
+        }
+        // South
+        else if(y + 1 < map->height && GetDistance(distances, (size_t)(y + 1) * map->width + x) == distance - 1)
+        {
+            y++;
+        }
+        // East
+        else if(x + 1 < map->width && GetDistance(distances, (size_t)y * map->width + x + 1) == distance - 1)
+        {
+            x++;
+        }
+        // West
+        else if(x > 0)
+        {
+            x--;
+        }
+    }
+    return (int)length;
+}
+
+/*
+    Find the shortest path between two cells without writing to the map, so any number of
+    threads can search one shared map at the same time, each with its own arena
+    start, end = cells to connect, anywhere on the map
+    path       = receives the cells from start to end if the path fits, can be NULL to only get the length
+    capacity   = number of nodes path can hold
+    arena      = arena for the scratch memory, reset before returning. NULL for malloc
+    stats      = receives the work done, can be NULL
+    Return the number of cells of the path including both ends, or 0 if out of memory or unreachable
+*/
+static int FindPath(const Map * map, Node start, Node end, Node * path, int capacity, Arena * arena, SolverStats * stats)
+{
+    if(!MapInBounds(map, start.x, start.y) || !MapInBounds(map, end.x, end.y))
+    {
+        return 0;
+    }
+    ArenaMark mark = arena ? Arena_namespace.Mark(arena) : 0;
+    DistanceBuffer distances;
+    int length = 0;
+    if(FloodDistances(map, start, end, &distances, arena, stats))
+    {
+        length = (int)GetDistance(&distances, (size_t)end.y * map->width + end.x);
+        TracePath(map, &distances, end, (length <= capacity) ? path : NULL, NULL);
+    }
+    if(distances.owned)
+    {
+        free(distances.data);
+    }
+    if(arena)
+    {
+        Arena_namespace.Reset(arena, mark);
+    }
+    return length;
+}
+
+/*
+    Solve the map with a breadth first flood from the start point
+    Distances are kept in a buffer of their own, the map is only written to mark the solution
+    with PATH cells
+    stats = receives the work done, can be NULL
+    Return FALSE if memory ran out or the end point cannot be reached, the map is left unsolved
+*/
+static BOOL Solve(Map * map, SolverStats * stats)
+{
+    if((map->format & MAP_PACKED) && !map->marks)
+    {
+        return FALSE;
+    }
+    Node start = {map->start, 0};
+    Node end = {map->end, map->height - 1};
+    // Scratch memory comes from the map's arena, if it has one
+    ArenaMark mark = map->arena ? Arena_namespace.Mark(map->arena) : 0;
+    DistanceBuffer distances;
+    BOOL found = FloodDistances(map, start, end, &distances, map->arena, stats);
+    if(found)
+    {
+        TracePath(map, &distances, end, NULL, map);
+    }
+    if(distances.owned)
+    {
+        free(distances.data);
+    }
+    if(map->arena)
+    {
+        Arena_namespace.Reset(map->arena, mark);
+    }
+    return found;
+}
+
+/*
+    Cells found by one thread during a level of the parallel search
+*/
+typedef struct ParallelList
+{
+    uint32_t * cells;
+    size_t count;
+    size_t capacity;
+    BOOL failed;    // Out of memory, the search is abandoned
+} ParallelList;
+
+/*
+    Shared state of one level of the parallel search, read by every worker
+    Cells are row-major indices, distances count from 1 at the start like Flood
+*/
+typedef struct ParallelLevel
+{
+    const Map * map;
+    uint32_t * distance;
+    const uint32_t * frontier;  // Cells at distance level
+    size_t frontierCount;
+    uint32_t level;
+    BOOL bottomUp;              // Unvisited cells look for a frontier neighbour instead of the reverse
+    int chunkSize;              // Frontier cells (top down) or rows (bottom up) per task index
+    ParallelList * lists;       // One per thread, receives the cells of the next level
+} ParallelLevel;
+
+/*
+    Add a cell to a thread's list, doubling its capacity when full
+*/
+static inline void AppendCell(ParallelList * list, uint32_t cell)
+{
+    if(list->count == list->capacity)
+    {
+        size_t capacity = list->capacity ? list->capacity * 2 : 1024;
+        uint32_t * cells = (uint32_t *)realloc(list->cells, capacity * sizeof(uint32_t));
+        if(!cells)
+        {
+            list->failed = TRUE;
+            return;
+        }
+        list->cells     = cells;
+        list->capacity  = capacity;
+    }
+    list->cells[list->count++] = cell;
+}
+
+/*
+    Pool task: expand one chunk of a level
+    Top down, every frontier cell claims its unvisited neighbours with a compare and swap, so each
+    cell joins exactly one list. Bottom up, every unvisited cell of a band of rows checks for a
+    neighbour on the frontier and only writes its own distance
+*/
+static void ExpandLevelChunk(void * context, int index, int thread)
+{
+    static const int offsets[4][2] = {{0, -1}, {0, 1}, {1, 0}, {-1, 0}}; // N, S, E, W
+    ParallelLevel * level = (ParallelLevel *)context;
+    const Map * map = level->map;
+    ParallelList * list = &level->lists[thread];
+    uint32_t next = level->level + 1;
+    if(!level->bottomUp)
+    {
+        size_t first = (size_t)index * level->chunkSize;
+        size_t last = __min(first + level->chunkSize, level->frontierCount);
+        for(size_t i = first; i < last; i++)
+        {
+            int x = level->frontier[i] % map->width;
+            int y = level->frontier[i] / map->width;
+            for(int ii = 0; ii < 4; ii++)
+            {
+                int nx = x + offsets[ii][0];
+                int ny = y + offsets[ii][1];
+                uint32_t cell = (uint32_t)ny * map->width + nx;
+                uint32_t unvisited = 0;
+                if(CellWalkable(map, nx, ny) && __atomic_load_n(&level->distance[cell], __ATOMIC_RELAXED) == 0
+                    && __atomic_compare_exchange_n(&level->distance[cell], &unvisited, next, FALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                {
+                    AppendCell(list, cell);
+                }
+            }
+        }
+        return;
+    }
+
+    int firstRow = index * level->chunkSize;
+    int lastRow = __min(firstRow + level->chunkSize, map->height);
+    for(int y = firstRow; y < lastRow; y++)
+    {
+        for(int x = 0; x < map->width; x++)
+        {
+            uint32_t cell = (uint32_t)y * map->width + x;
+            if(__atomic_load_n(&level->distance[cell], __ATOMIC_RELAXED) != 0 || MapGetUnchecked(map, x, y) == WALL)
+            {
+                continue;
+            }
+            for(int ii = 0; ii < 4; ii++)
+            {
+                int nx = x + offsets[ii][0];
+                int ny = y + offsets[ii][1];
+                if(MapInBounds(map, nx, ny)
+                    && __atomic_load_n(&level->distance[(size_t)ny * map->width + nx], __ATOMIC_RELAXED) == level->level)
+                {
+                    __atomic_store_n(&level->distance[cell], next, __ATOMIC_RELAXED);
+                    AppendCell(list, cell);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/*
+    Solve the map with a level-synchronous breadth first search spread over a pool of threads
+    Each level of the frontier is split into chunks that the threads claim one at a time. Levels
+    whose frontier covers a large part of the unvisited map switch to bottom-up expansion, which
+    scans the unvisited cells instead of the frontier's edges (direction optimisation).
+    Small levels run on the calling thread, so narrow mazes with thousands of tiny levels do not
+    pay a pool wake-up per level. Distances are BFS levels, so the PATH cells are exactly those
+    of Solve
+    Packed maps need MAP_SCRATCH to hold the PATH marks
+    pool  = threads to use, NULL to run on the calling thread only. Must not be running another task
+    stats = receives the work done (frontier cells expanded), can be NULL
+    Return FALSE if memory ran out or the end point cannot be reached
+*/
+static BOOL SolveParallel(Map * map, Pool * pool, SolverStats * stats)
+{
+    if((map->format & MAP_PACKED) && !map->marks)
+    {
+        return FALSE;
+    }
+    Node start = {map->start, 0};
+    Node end = {map->end, map->height - 1};
+    if(!CellWalkable(map, start.x, start.y) || !CellWalkable(map, end.x, end.y))
+    {
+        return FALSE;
+    }
+    size_t cells = (size_t)map->width * map->height;
+    int threadCount = pool ? pool->threadCount : 1;
+    ArenaMark mark = map->arena ? Arena_namespace.Mark(map->arena) : 0;
+    DistanceBuffer distances;
+    distances.wide = TRUE; // Compare and swap works on whole 32-bit cells
+    distances.data = ScratchAllocArena(map->arena, cells * sizeof(uint32_t), &distances.owned);
+    ParallelList * lists = (ParallelList *)calloc(threadCount, sizeof(ParallelList));
+    ParallelList frontier = {NULL, 0, 0, FALSE};
+    BOOL running = distances.data && lists;
+
+    ParallelLevel level;
+    level.map       = map;
+    level.distance  = (uint32_t *)distances.data;
+    level.level     = 1;
+    level.bottomUp  = FALSE;
+    level.lists     = lists;
+    if(running)
+    {
+        AppendCell(&frontier, (uint32_t)map->start);
+        level.distance[map->start] = 1;
+    }
+    size_t endCell = (size_t)end.y * map->width + end.x;
+    size_t visited = 1;
+    size_t expanded = 0;
+    while(running && !frontier.failed && frontier.count && !level.distance[endCell])
+    {
+        // Bottom up pays off once the frontier's edges outnumber the unvisited cells to scan,
+        // and is dropped again once the frontier shrinks (thresholds from Beamer et al.)
+        level.bottomUp = level.bottomUp
+            ? frontier.count >= cells / PARALLEL_BETA
+            : frontier.count * 4 > (cells - visited) / PARALLEL_ALPHA;
+        level.frontier      = frontier.cells;
+        level.frontierCount = frontier.count;
+        level.chunkSize     = level.bottomUp ? __max(1, PARALLEL_CHUNK / map->width) : PARALLEL_CHUNK;
+        int chunks = level.bottomUp
+            ? (map->height + level.chunkSize - 1) / level.chunkSize
+            : (int)((frontier.count + PARALLEL_CHUNK - 1) / PARALLEL_CHUNK);
+        if(pool && (level.bottomUp || frontier.count >= PARALLEL_MIN_FRONTIER))
+        {
+            Pool_namespace.Run(pool, chunks, ExpandLevelChunk, &level);
+        }
+        else
+        {
+            for(int i = 0; i < chunks; i++)
+            {
+                ExpandLevelChunk(&level, i, 0);
+            }
+        }
+        expanded += frontier.count;
+
+        // Gather the next level from the thread lists
+        frontier.count = 0;
+        for(int i = 0; i < threadCount; i++)
+        {
+            running = running && !lists[i].failed;
+            for(size_t ii = 0; ii < lists[i].count && running; ii++)
+            {
+                AppendCell(&frontier, lists[i].cells[ii]);
+            }
+            lists[i].count = 0;
+        }
+        visited += frontier.count;
+        level.level++;
+    }
+    if(stats)
+    {
+        stats->expanded = expanded;
+    }
+
+    BOOL found = running && !frontier.failed && level.distance[endCell];
+    if(found)
+    {
+        TracePath(map, &distances, end, NULL, map);
+    }
+    for(int i = 0; lists && i < threadCount; i++)
+    {
+        free(lists[i].cells);
+    }
+    free(lists);
+    free(frontier.cells);
+    if(distances.owned)
+    {
+        free(distances.data);
+    }
+    if(map->arena)
+    {
+        Arena_namespace.Reset(map->arena, mark);
+    }
+    return found;
+}
+
+// Pool of one thread per core for the solver table's parallel entry, started on first use
+// and kept for the life of the process
+static Pool sharedPool;
+static BOOL sharedPoolReady = FALSE;
+static pthread_once_t sharedPoolOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t sharedPoolLock = PTHREAD_MUTEX_INITIALIZER;
+
+static void InitSharedPool(void)
+{
+    sharedPoolReady = Pool_namespace.Init(&sharedPool, 0);
+}
+
+/*
+    SolveParallel on the shared pool of every core
+    Called from a task of a pool of several threads, for example a batch that solves one map per
+    thread, the map is solved on the calling thread: the cores are already busy. The same goes
+    when another caller holds the shared pool, the map is solved here instead of waiting
+*/
+static BOOL SolveParallelShared(Map * map, SolverStats * stats)
+{
+    if(Pool_namespace.InTask())
+    {
+        return SolveParallel(map, NULL, stats);
+    }
+    pthread_once(&sharedPoolOnce, InitSharedPool);
+    BOOL locked = sharedPoolReady && pthread_mutex_trylock(&sharedPoolLock) == 0;
+    BOOL solved = SolveParallel(map, locked ? &sharedPool : NULL, stats);
+    if(locked)
+    {
+        pthread_mutex_unlock(&sharedPoolLock);
+    }
+    return solved;
+}
+
+/*
+    Words of the bitboard frontier log: the cells of one BFS level that fall in one 64-cell word
+*/
+typedef struct FrontierWord
+{
+    int row;
+    int word;
+    uint64_t bits;
+} FrontierWord;
+
+/*
+    Growable log of frontier words, with the index of the first word of every level
+*/
+typedef struct FrontierLog
+{
+    FrontierWord * words;
+    size_t count;
+    size_t capacity;
+    size_t * levels;    // levels[i] = index of the first word of level i
+    size_t levelCount;
+    size_t levelCapacity;
+} FrontierLog;
+
+/*
+    Append a word to the log
+    Return FALSE if the log could not grow
+*/
+static BOOL AppendWord(FrontierLog * log, int row, int word, uint64_t bits)
+{
+    if(log->count == log->capacity)
+    {
+        log->capacity = log->capacity ? log->capacity * 2 : 256;
+        if(!ResizeArray((void **)&log->words, log->capacity, sizeof(FrontierWord)))
+        {
+            log->words = NULL;
+            return FALSE;
+        }
+    }
+    FrontierWord * entry = &log->words[log->count++];
+    entry->row  = row;
+    entry->word = word;
+    entry->bits = bits;
+    return TRUE;
+}
+
+/*
+    Start a new level at the end of the log
+    Return FALSE if the log could not grow
+*/
+static BOOL AppendLevel(FrontierLog * log)
+{
+    if(log->levelCount == log->levelCapacity)
+    {
+        log->levelCapacity = log->levelCapacity ? log->levelCapacity * 2 : 256;
+        if(!ResizeArray((void **)&log->levels, log->levelCapacity, sizeof(size_t)))
+        {
+            log->levels = NULL;
+            return FALSE;
+        }
+    }
+    log->levels[log->levelCount++] = log->count;
+    return TRUE;
+}
+
+/*
+    Add the open, unvisited cells among the given bits to a word of the next frontier, and mark them visited
+    The first time a word is touched it is appended to the log, its bits are filled in after the spread
+*/
+static inline BOOL TouchWord(FrontierLog * log, uint64_t * next, const uint64_t * open, uint64_t * visited,
+    int stride, int row, int word, uint64_t bits)
+{
+    size_t index = (size_t)row * stride + word;
+    bits &= open[index] & ~visited[index];
+    if(!bits)
+    {
+        return TRUE;
+    }
+    visited[index] |= bits;
+    BOOL touched = next[index] != 0;
+    next[index] |= bits;
+    return touched || AppendWord(log, row, word, 0);
+}
+
+/*
+    Return TRUE if the bit of a cell is set in a plane of bit rows
+*/
+static inline BOOL TestBit(const uint64_t * plane, int stride, int x, int y)
+{
+    return (plane[(size_t)y * stride + x / WORD_BITS] >> (x % WORD_BITS)) & 1;
+}
+
+/*
+    Allocate zeroed scratch memory from the map's arena, or with calloc if it has none or it is full
+    owned = set to TRUE if the memory was calloc'd and must be freed
+*/
+static void * ScratchAlloc(Map * map, size_t size, BOOL * owned)
+{
+    return ScratchAllocArena(map->arena, size, owned);
+}
+
+/*
+    Solve the map with a word-parallel breadth first search
+    The frontier and the visited cells are bit rows, every frontier word is spread to its
+    neighbours with shifts and masked with the open cells 64 cells at a time. Each level of the
+    frontier is logged, so the path can be walked back with the same N, S, E, W preference as Solve
+    and the PATH cells are exactly the ones Solve marks
+    Fastest on packed maps, which need MAP_SCRATCH to hold the PATH marks. Other maps are converted
+    to bit rows first
+    stats = receives the work done, can be NULL
+    Return FALSE if memory ran out, the end point cannot be reached or a packed map has no scratch plane
+*/
+static BOOL SolveBitboard(Map * map, SolverStats * stats)
+{
+    if((map->format & MAP_PACKED) && !map->marks)
+    {
+        return FALSE;
+    }
+    int stride = (map->width + WORD_BITS - 1) / WORD_BITS;
+    size_t words = (size_t)stride * map->height;
+    uint64_t lastMask = (map->width % WORD_BITS) ? ((uint64_t)1 << (map->width % WORD_BITS)) - 1 : ~(uint64_t)0;
+
+    // Scratch memory comes from the map's arena, if it has one
+    ArenaMark mark = map->arena ? Arena_namespace.Mark(map->arena) : 0;
+    BOOL owned;
+    uint64_t * open = (uint64_t *)ScratchAlloc(map, 3 * words * sizeof(uint64_t), &owned);
+    if(!open)
+    {
+        return FALSE;
+    }
+    uint64_t * visited  = open + words;     // Cells reached so far
+    uint64_t * next     = visited + words;  // Candidates of the next level, all zero between levels
+
+    // Every cell but a WALL can be walked on, like in Solve (CellWalkable)
+    for(int y = 0; y < map->height; y++)
+    {
+        for(int w = 0; w < stride; w++)
+        {
+            size_t index = (size_t)y * stride + w;
+            uint64_t blocked = 0;
+            if(map->format & MAP_PACKED)
+            {
+                blocked = map->walls[index];
+            }
+            else
+            {
+                for(int i = 0, x = w * WORD_BITS; i < WORD_BITS && x < map->width; i++, x++)
+                {
+                    blocked |= (uint64_t)(MapGetUnchecked(map, x, y) == WALL) << i;
+                }
+            }
+            open[index] = ~blocked & ((w == stride - 1) ? lastMask : ~(uint64_t)0);
+        }
+    }
+
+    FrontierLog log = {NULL, 0, 0, NULL, 0, 0};
+    size_t expanded = 0;
+    size_t endIndex = (size_t)(map->height - 1) * stride + map->end / WORD_BITS;
+    uint64_t endBit = (uint64_t)1 << (map->end % WORD_BITS);
+    size_t startIndex = (size_t)map->start / WORD_BITS;
+    uint64_t startBit = (uint64_t)1 << (map->start % WORD_BITS);
+    BOOL running = AppendLevel(&log) && AppendWord(&log, 0, map->start / WORD_BITS, startBit);
+    visited[startIndex] = startBit;
+    BOOL found = (visited[endIndex] & endBit) != 0;
+
+    // Walk away from the start location one level at a time
+    while(running && !found && log.levels[log.levelCount - 1] < log.count)
+    {
+        size_t first = log.levels[log.levelCount - 1];
+        size_t last = log.count;
+        running = AppendLevel(&log);
+
+        // Spread every word of the level to its neighbours: east and west by shifting
+        // (carrying into the adjacent words), north and south as is
+        for(size_t i = first; i < last && running; i++)
+        {
+            FrontierWord entry = log.words[i];
+            uint64_t bits = entry.bits;
+            expanded += __builtin_popcountll(bits);
+            running = TouchWord(&log, next, open, visited, stride, entry.row, entry.word, (bits << 1) | (bits >> 1))
+                && (entry.word + 1 >= stride || TouchWord(&log, next, open, visited, stride, entry.row, entry.word + 1, bits >> (WORD_BITS - 1)))
+                && (entry.word == 0 || TouchWord(&log, next, open, visited, stride, entry.row, entry.word - 1, bits << (WORD_BITS - 1)))
+                && (entry.row == 0 || TouchWord(&log, next, open, visited, stride, entry.row - 1, entry.word, bits))
+                && (entry.row + 1 >= map->height || TouchWord(&log, next, open, visited, stride, entry.row + 1, entry.word, bits));
+        }
+
+        // Move the collected words of the new level into the log
+        for(size_t i = last; i < log.count && running; i++)
+        {
+            size_t index = (size_t)log.words[i].row * stride + log.words[i].word;
+            log.words[i].bits = next[index];
+            next[index] = 0;
+        }
+        found = (visited[endIndex] & endBit) != 0;
+    }
+    if(stats)
+    {
+        stats->expanded = expanded;
+    }
+
+    // Walk back towards the start, one level at a time, marking nodes as solution on the way
+    // The previous level is laid out in the next plane to look the neighbours up
+    if(running && found)
+    {
+        int x = map->end;
+        int y = map->height - 1;
+        MapSetUnchecked(map, x, y, PATH);
+        for(size_t level = log.levelCount - 1; level-- > 0;)
+        {
+            size_t first = log.levels[level];
+            size_t last = log.levels[level + 1];
+            for(size_t i = first; i < last; i++)
+            {
+                next[(size_t)log.words[i].row * stride + log.words[i].word] = log.words[i].bits;
+            }
+            // North
+            if(y > 0 && TestBit(next, stride, x, y - 1))
+            {
+                y--;
+            }
+            // South
+            else if(y + 1 < map->height && TestBit(next, stride, x, y + 1))
+            {
+                y++;
+            }
+            // East
+            else if(x + 1 < map->width && TestBit(next, stride, x + 1, y))
+            {
+                x++;
+            }
+            // West
+            else if(x > 0 && TestBit(next, stride, x - 1, y))
+            {
+                x--;
+            }
+            for(size_t i = first; i < last; i++)
+            {
+                next[(size_t)log.words[i].row * stride + log.words[i].word] = 0;
+            }
+            MapSetUnchecked(map, x, y, PATH);
+        }
+    }
+
+    free(log.words);
+    free(log.levels);
+    if(owned)
+    {
+        free(open);
+    }
+    else
+    {
+        Arena_namespace.Reset(map->arena, mark);
+    }
+    return running && found;
+}
+
+/*
+    Return TRUE if the start and end points can be walked on and the map can hold PATH marks:
+    packed maps need MAP_SCRATCH
+*/
+static BOOL EndpointsOpen(const Map * map)
+{
+    if((map->format & MAP_PACKED) && !map->marks)
+    {
+        return FALSE;
+    }
+    return CellWalkable(map, map->start, 0) && CellWalkable(map, map->end, map->height - 1);
+}
+
+/*
+    Mark the path from a cell back to the origin of its search with PATH cells
+    Every step goes to the neighbour one closer to the origin, preferring N, S, E, W like Solve
+    distance = signed distances of the search, origin = 1 (or -1)
+    step     = +1 for distances counted from the start, -1 for distances counted from the end
+*/
+static void MarkPathBack(Map * map, const int32_t * distance, int x, int y, int step)
+{
+    int32_t value = distance[(size_t)y * map->width + x];
+    while(TRUE)
+    {
+        MapSetUnchecked(map, x, y, PATH);
+        if(value == step)
+        {
+            return;
+        }
+        value -= step;
+        // North
+        if(y > 0 && distance[(size_t)(y - 1) * map->width + x] == value)
+        {
+            y--;
+        }
+        // South
+        else if(y + 1 < map->height && distance[(size_t)(y + 1) * map->width + x] == value)
+        {
+            y++;
+        }
+        // East
+        else if(x + 1 < map->width && distance[(size_t)y * map->width + x + 1] == value)
+        {
+            x++;
+        }
+        // West
+        else if(x > 0 && distance[(size_t)y * map->width + x - 1] == value)
+        {
+            x--;
+        }
+        else
+        {
+            return;
+        }
+    }
+}
+
+/*
+    Solve the map with two breadth first searches, one from the start and one from the end,
+    that stop where they meet
+    The side with the smaller frontier grows by one whole level at a time. The shortest of the
+    meetings found in that level is the shortest path. Distances are kept in a separate buffer,
+    positive from the start and negative from the end, so the map is only written to mark the PATH
+    The path is a shortest path but can differ from the one Solve picks when there are several
+    Packed maps need MAP_SCRATCH to hold the PATH marks
+    stats = receives the work done, can be NULL
+    Return FALSE if memory ran out, the end point cannot be reached or a packed map has no scratch plane
+*/
+static BOOL SolveBidirectional(Map * map, SolverStats * stats)
+{
+    static const int offsets[4][2] = {{0, -1}, {0, 1}, {1, 0}, {-1, 0}}; // N, S, E, W
+    if(!EndpointsOpen(map))
+    {
+        return FALSE;
+    }
+    Node ends[2] = {{map->start, 0}, {map->end, map->height - 1}};
+
+    // On a one-row map the start can be the end, the signed distances cannot hold both searches there
+    if(ends[0].x == ends[1].x && ends[0].y == ends[1].y)
+    {
+        MapSetUnchecked(map, ends[0].x, ends[0].y, PATH);
+        if(stats)
+        {
+            stats->expanded = 0;
+        }
+        return TRUE;
+    }
+
+    // Scratch memory comes from the map's arena, if it has one
+    ArenaMark mark = map->arena ? Arena_namespace.Mark(map->arena) : 0;
+    BOOL owned;
+    int32_t * distance = (int32_t *)ScratchAlloc(map, (size_t)map->width * map->height * sizeof(int32_t), &owned);
+    if(!distance)
+    {
+        return FALSE;
+    }
+    Queue queues[2];
+    BOOL running = Queue_namespace.InitArena(&queues[0], sizeof(Node), map->width + map->height, map->arena);
+    running = Queue_namespace.InitArena(&queues[1], sizeof(Node), map->width + map->height, map->arena) && running;
+    running = running && Queue_namespace.Push(&queues[0], &ends[0]) && Queue_namespace.Push(&queues[1], &ends[1]);
+    distance[ends[0].x] = 1;
+    distance[(size_t)ends[1].y * map->width + ends[1].x] = -1;
+
+    // Length of the best path found so far and the cells either side of where the searches met
+    int32_t best = INT32_MAX;
+    Node meet[2] = {ends[0], ends[1]};
+    size_t expanded = 0;
+    while(running && best == INT32_MAX && Queue_namespace.Size(&queues[0]) && Queue_namespace.Size(&queues[1]))
+    {
+        int side = (Queue_namespace.Size(&queues[0]) <= Queue_namespace.Size(&queues[1])) ? 0 : 1;
+        int32_t step = side ? -1 : 1;
+        size_t distanceMax = Queue_namespace.Size(&queues[side]); // Nodes of the current level
+        for(size_t i = 0; i < distanceMax && running; i++)
+        {
+            Node node;
+            Queue_namespace.Pop(&queues[side], &node);
+            expanded++;
+            int32_t value = distance[(size_t)node.y * map->width + node.x];
+            for(int ii = 0; ii < 4 && running; ii++)
+            {
+                Node next = {node.x + offsets[ii][0], node.y + offsets[ii][1]};
+                if(!CellWalkable(map, next.x, next.y))
+                {
+                    continue;
+                }
+                int32_t * other = &distance[(size_t)next.y * map->width + next.x];
+                if(*other == 0)
+                {
+                    *other = value + step;
+                    running = Queue_namespace.Push(&queues[side], &next);
+                }
+                else if((*other > 0) != (step > 0))
+                {
+                    // Reached by the other search: both distances count cells, so they add up to the path length
+                    int32_t length = (value > 0 ? value : -value) + (*other > 0 ? *other : -*other);
+                    if(length < best)
+                    {
+                        best = length;
+                        meet[side] = node;
+                        meet[1 - side] = next;
+                    }
+                }
+            }
+        }
+    }
+    if(stats)
+    {
+        stats->expanded = expanded;
+    }
+
+    BOOL found = running && best != INT32_MAX;
+    if(found)
+    {
+        MarkPathBack(map, distance, meet[0].x, meet[0].y, 1);
+        MarkPathBack(map, distance, meet[1].x, meet[1].y, -1);
+    }
+
+    Queue_namespace.Destroy(&queues[0]);
+    Queue_namespace.Destroy(&queues[1]);
+    if(owned)
+    {
+        free(distance);
+    }
+    if(map->arena)
+    {
+        Arena_namespace.Reset(map->arena, mark);
+    }
+    return found;
+}
+
+/*
+    Manhattan distance from a cell to the end point, never more than the real distance
+*/
+static inline uint32_t DistanceToEnd(const Map * map, int x, int y)
+{
+    return (uint32_t)(abs(x - map->end) + (map->height - 1 - y));
+}
+
+/*
+    Heap key of a node: smallest estimated path length first, and of those the node furthest
+    from the start, which follows one path through open areas instead of widening over all of them
+    cost      = distance from the start, plus one
+    heuristic = estimated distance to the end
+*/
+static inline uint64_t SearchKey(uint32_t cost, uint32_t heuristic)
+{
+    return ((uint64_t)(cost + heuristic) << 32) | (UINT32_MAX - cost);
+}
+
+/*
+    Cost stored in the key of a heap entry
+*/
+static inline uint32_t SearchCost(HeapEntry entry)
+{
+    return UINT32_MAX - (uint32_t)entry.key;
+}
+
+/*
+    Solve the map using A* with the Manhattan distance to the end as heuristic
+    Costs are kept in a separate buffer, the heap holds stale entries of nodes whose cost improved
+    after they were pushed, which are skipped when popped. The heuristic is consistent, so every
+    node is expanded at most once and the first time the end is popped its cost is final
+    The path has the length of the one Solve finds, but can take a different route
+    Packed maps need MAP_SCRATCH to hold the PATH marks
+    stats = receives the work done, can be NULL
+    Return FALSE if memory ran out, the end point cannot be reached or a packed map has no scratch plane
+*/
+static BOOL SolveAStar(Map * map, SolverStats * stats)
+{
+    static const int offsets[4][2] = {{0, -1}, {0, 1}, {1, 0}, {-1, 0}}; // N, S, E, W
+    if(!EndpointsOpen(map))
+    {
+        return FALSE;
+    }
+
+    // Scratch memory comes from the map's arena, if it has one
+    ArenaMark mark = map->arena ? Arena_namespace.Mark(map->arena) : 0;
+    BOOL owned;
+    int32_t * cost = (int32_t *)ScratchAlloc(map, (size_t)map->width * map->height * sizeof(int32_t), &owned);
+    if(!cost)
+    {
+        return FALSE;
+    }
+    Heap heap;
+    uint32_t endIndex = (uint32_t)(map->height - 1) * map->width + map->end;
+    cost[map->start] = 1;
+    BOOL running = Heap_namespace.InitArena(&heap, map->width + map->height, map->arena)
+        && Heap_namespace.Push(&heap, SearchKey(1, DistanceToEnd(map, map->start, 0)), map->start);
+
+    BOOL found = FALSE;
+    size_t expanded = 0;
+    HeapEntry entry;
+    while(running && !found && Heap_namespace.Pop(&heap, &entry))
+    {
+        uint32_t value = SearchCost(entry);
+        if((uint32_t)cost[entry.value] != value)
+        {
+            continue; // Stale, the node was pushed again with a lower cost
+        }
+        found = (entry.value == endIndex);
+        expanded += !found;
+        int x = entry.value % map->width;
+        int y = entry.value / map->width;
+        for(int i = 0; i < 4 && running && !found; i++)
+        {
+            int nx = x + offsets[i][0];
+            int ny = y + offsets[i][1];
+            uint32_t next = (uint32_t)ny * map->width + nx;
+            if(CellWalkable(map, nx, ny) && (cost[next] == 0 || (uint32_t)cost[next] > value + 1))
+            {
+                cost[next] = value + 1;
+                running = Heap_namespace.Push(&heap, SearchKey(value + 1, DistanceToEnd(map, nx, ny)), next);
+            }
+        }
+    }
+    if(stats)
+    {
+        stats->expanded = expanded;
+    }
+    if(found)
+    {
+        MarkPathBack(map, cost, map->end, map->height - 1, 1);
+    }
+
+    Heap_namespace.Destroy(&heap);
+    if(owned)
+    {
+        free(cost);
+    }
+    if(map->arena)
+    {
+        Arena_namespace.Reset(map->arena, mark);
+    }
+    return found;
+}
+
+/*
+    Move horizontally from a cell until reaching a jump point: the end point, or a cell with an
+    open vertical neighbour that the cell behind it does not have (a forced neighbour).
+    Paths turn from horizontal to vertical only there, any other turn has an equally long path that
+    turns earlier
+    dx   = direction, 1 for east or -1 for west
+    jump = receives the jump point
+    Return FALSE if a wall or the map edge was hit first
+*/
+static BOOL JumpHorizontal(const Map * map, int x, int y, int dx, Node * jump)
+{
+    while(TRUE)
+    {
+        x += dx;
+        if(!CellWalkable(map, x, y))
+        {
+            return FALSE;
+        }
+        if((y == map->height - 1 && x == map->end)
+            || (CellWalkable(map, x, y - 1) && !CellWalkable(map, x - dx, y - 1))
+            || (CellWalkable(map, x, y + 1) && !CellWalkable(map, x - dx, y + 1)))
+        {
+            jump->x = x;
+            jump->y = y;
+            return TRUE;
+        }
+    }
+}
+
+/*
+    Move vertically from a cell until reaching a jump point: the end point, or a cell from which
+    a horizontal jump finds a jump point
+    dy   = direction, 1 for south or -1 for north
+    jump = receives the jump point
+    Return FALSE if a wall or the map edge was hit first
+*/
+static BOOL JumpVertical(const Map * map, int x, int y, int dy, Node * jump)
+{
+    Node ignored;
+    while(TRUE)
+    {
+        y += dy;
+        if(!CellWalkable(map, x, y))
+        {
+            return FALSE;
+        }
+        if((y == map->height - 1 && x == map->end)
+            || JumpHorizontal(map, x, y, 1, &ignored) || JumpHorizontal(map, x, y, -1, &ignored))
+        {
+            jump->x = x;
+            jump->y = y;
+            return TRUE;
+        }
+    }
+}
+
+/*
+    Solve the map using Jump Point Search, A* over the jump points of a 4-connected grid
+    Instead of pushing every neighbour, a node jumps in a straight line to the next cell where the
+    path might have to turn, so runs of cells with no choice in between are never queued.
+    Vertical moves may be followed by either horizontal move, horizontal moves only continue
+    or turn at forced neighbours. Best on open maps, on narrow mazes nearly every cell is a jump point
+    The path has the length of the one Solve finds, but can take a different route
+    Packed maps need MAP_SCRATCH to hold the PATH marks
+    stats = receives the work done, expanded counts jump points. Can be NULL
+    Return FALSE if memory ran out, the end point cannot be reached or a packed map has no scratch plane
+*/
+static BOOL SolveJumpPoint(Map * map, SolverStats * stats)
+{
+    if(!EndpointsOpen(map))
+    {
+        return FALSE;
+    }
+
+    // Cost of every jump point, and the jump point it was reached from
+    ArenaMark mark = map->arena ? Arena_namespace.Mark(map->arena) : 0;
+    size_t cells = (size_t)map->width * map->height;
+    BOOL owned;
+    int32_t * cost = (int32_t *)ScratchAlloc(map, cells * 2 * sizeof(int32_t), &owned);
+    if(!cost)
+    {
+        return FALSE;
+    }
+    uint32_t * parent = (uint32_t *)(cost + cells);
+    Heap heap;
+    uint32_t endIndex = (uint32_t)(map->height - 1) * map->width + map->end;
+    cost[map->start] = 1;
+    parent[map->start] = map->start;
+    BOOL running = Heap_namespace.InitArena(&heap, map->width + map->height, map->arena)
+        && Heap_namespace.Push(&heap, SearchKey(1, DistanceToEnd(map, map->start, 0)), map->start);
+
+    BOOL found = FALSE;
+    size_t expanded = 0;
+    HeapEntry entry;
+    while(running && !found && Heap_namespace.Pop(&heap, &entry))
+    {
+        uint32_t value = SearchCost(entry);
+        if((uint32_t)cost[entry.value] != value)
+        {
+            continue; // Stale, the node was pushed again with a lower cost
+        }
+        found = (entry.value == endIndex);
+        if(found)
+        {
+            break;
+        }
+        expanded++;
+        int x = entry.value % map->width;
+        int y = entry.value / map->width;
+        int px = parent[entry.value] % map->width;
+        int py = parent[entry.value] / map->width;
+        int dx = (x > px) - (x < px);
+        int dy = (y > py) - (y < py);
+
+        // The start jumps in every direction. A vertical arrival continues and branches both ways,
+        // a horizontal arrival continues and turns only towards forced neighbours
+        Node jumps[4];
+        int jumpCount = 0;
+        if(dx == 0)
+        {
+            jumpCount += JumpHorizontal(map, x, y, 1, &jumps[jumpCount]);
+            jumpCount += JumpHorizontal(map, x, y, -1, &jumps[jumpCount]);
+        }
+        else
+        {
+            jumpCount += JumpHorizontal(map, x, y, dx, &jumps[jumpCount]);
+        }
+        for(int vertical = -1; vertical <= 1; vertical += 2)
+        {
+            if(dy == -vertical)
+            {
+                continue; // Back where it came from
+            }
+            if(dx == 0 || (CellWalkable(map, x, y + vertical) && !CellWalkable(map, x - dx, y + vertical)))
+            {
+                jumpCount += JumpVertical(map, x, y, vertical, &jumps[jumpCount]);
+            }
+        }
+
+        for(int i = 0; i < jumpCount && running; i++)
+        {
+            uint32_t next = (uint32_t)jumps[i].y * map->width + jumps[i].x;
+            uint32_t nextCost = value + abs(jumps[i].x - x) + abs(jumps[i].y - y);
+            if(cost[next] == 0 || (uint32_t)cost[next] > nextCost)
+            {
+                cost[next] = nextCost;
+                parent[next] = entry.value;
+                running = Heap_namespace.Push(&heap, SearchKey(nextCost, DistanceToEnd(map, jumps[i].x, jumps[i].y)), next);
+            }
+        }
+    }
+    if(stats)
+    {
+        stats->expanded = expanded;
+    }
+
+    // Walk back along the straight lines between the jump points, marking them as solution
+    if(found)
+    {
+        uint32_t index = endIndex;
+        MapSetUnchecked(map, map->end, map->height - 1, PATH);
+        while(index != (uint32_t)map->start)
+        {
+            int x = index % map->width;
+            int y = index / map->width;
+            int px = parent[index] % map->width;
+            int py = parent[index] / map->width;
+            while(x != px || y != py)
+            {
+                x += (px > x) - (px < x);
+                y += (py > y) - (py < y);
+                MapSetUnchecked(map, x, y, PATH);
+            }
+            index = parent[index];
+        }
+    }
+
+    Heap_namespace.Destroy(&heap);
+    if(owned)
+    {
+        free(cost);
+    }
+    if(map->arena)
+    {
+        Arena_namespace.Reset(map->arena, mark);
+    }
+    return found;
+}
+
+/*
+    Return the 2-bit code of a cell in a distance-mod-3 plane: 0 for cells not reached,
+    otherwise the distance from the start modulo 3, plus one
+*/
+static inline uint32_t GetTrit(const uint64_t * plane, size_t index)
+{
+    return (uint32_t)(plane[index / 32] >> ((index % 32) * 2)) & 3;
+}
+
+/*
+    Set the code of a cell that was not reached yet
+*/
+static inline void SetTrit(uint64_t * plane, size_t index, uint32_t code)
+{
+    plane[index / 32] |= (uint64_t)code << ((index % 32) * 2);
+}
+
+/*
+    Solve the map breadth first keeping only the distance modulo 3 of every cell, in 2 bits
+    Neighbours of a cell are one step closer, as far or one step further from the start, which
+    are three different values modulo 3, so the code alone tells which neighbour to walk back to.
+    Code 0 marks cells not reached, so no separate visited plane is needed. Scratch memory is
+    2 bits per cell plus the frontier, against 16 or 32 bits per cell for Solve
+    blocked = bit rows of extra cells to keep out of the search, stride words per row, can be NULL
+    stats   = receives the work done, can be NULL
+    Return FALSE if memory ran out or the end point cannot be reached, the map is left unsolved
+*/
+static BOOL CompactSearch(Map * map, const uint64_t * blocked, int stride, SolverStats * stats)
+{
+    static const int offsets[4][2] = {{0, -1}, {0, 1}, {1, 0}, {-1, 0}}; // N, S, E, W
+    ArenaMark mark = map->arena ? Arena_namespace.Mark(map->arena) : 0;
+    size_t cells = (size_t)map->width * map->height;
+    BOOL owned;
+    uint64_t * plane = (uint64_t *)ScratchAllocArena(map->arena, (cells + 31) / 32 * sizeof(uint64_t), &owned);
+    uint32_t start = (uint32_t)map->start;
+    uint32_t end = (uint32_t)(map->height - 1) * map->width + map->end;
+    Queue queue;
+    BOOL running = plane && Queue_namespace.InitArena(&queue, sizeof(uint32_t), map->width + map->height, map->arena);
+    BOOL queued = running;
+    if(running)
+    {
+        SetTrit(plane, start, 1);
+        running = Queue_namespace.Push(&queue, &start);
+    }
+
+    // Walk away from the start, codes cycle 1, 2, 3 with the distance
+    BOOL found = FALSE;
+    size_t expanded = 0;
+    uint32_t cell;
+    while(running && Queue_namespace.Pop(&queue, &cell))
+    {
+        if(cell == end)
+        {
+            found = TRUE;
+            break;
+        }
+        expanded++;
+        uint32_t code = GetTrit(plane, cell) % 3 + 1;
+        int x = cell % map->width;
+        int y = cell / map->width;
+        for(int i = 0; i < 4 && running; i++)
+        {
+            int nx = x + offsets[i][0];
+            int ny = y + offsets[i][1];
+            uint32_t next = (uint32_t)ny * map->width + nx;
+            if(CellWalkable(map, nx, ny) && !GetTrit(plane, next) && !(blocked && TestBit(blocked, stride, nx, ny)))
+            {
+                SetTrit(plane, next, code);
+                running = Queue_namespace.Push(&queue, &next);
+            }
+        }
+    }
+    if(queued)
+    {
+        Queue_namespace.Destroy(&queue);
+    }
+
+    // Walk back to the neighbour whose code is one step closer, preferring N, S, E, W
+    if(found)
+    {
+        int x = map->end;
+        int y = map->height - 1;
+        cell = end;
+        MapSetUnchecked(map, x, y, PATH);
+        while(cell != start)
+        {
+            uint32_t closer = (GetTrit(plane, cell) + 1) % 3 + 1;
+            for(int i = 0; i < 4; i++)
+            {
+                int nx = x + offsets[i][0];
+                int ny = y + offsets[i][1];
+                if(MapInBounds(map, nx, ny) && GetTrit(plane, (size_t)ny * map->width + nx) == closer)
+                {
+                    x = nx;
+                    y = ny;
+                    break;
+                }
+            }
+            cell = (uint32_t)y * map->width + x;
+            MapSetUnchecked(map, x, y, PATH);
+        }
+    }
+    if(stats)
+    {
+        stats->expanded = expanded;
+    }
+    if(owned)
+    {
+        free(plane);
+    }
+    if(map->arena)
+    {
+        Arena_namespace.Reset(map->arena, mark);
+    }
+    return found;
+}
+
+/*
+    Solve the map with CompactSearch over every walkable cell
+    stats = receives the work done, can be NULL
+    Return FALSE if memory ran out or the end point cannot be reached
+*/
+static BOOL SolveCompact(Map * map, SolverStats * stats)
+{
+    return EndpointsOpen(map) && CompactSearch(map, NULL, 0, stats);
+}
+
+/*
+    Fill the dead ends of a map into a bit plane: open cells with at most one open neighbour are
+    closed, which can turn their neighbour into a dead end, until only cells on loops or on the way
+    between the start and end points are left. Those two cells are never filled.
+    The first dead ends are found 64 cells at a time from the open neighbours of every row word,
+    the chains they start are then followed with a worklist, so each cell is filled at most once
+    closed = receives bit rows of the cells that are not open, walls and filled cells, stride words
+             per row and zero past the map width
+    Return the number of cells filled, or -1 if memory ran out
+*/
+static long long FillPlane(const Map * map, uint64_t * closed, int stride)
+{
+    static const int offsets[4][2] = {{0, -1}, {0, 1}, {1, 0}, {-1, 0}};
+    uint64_t lastMask = (map->width % WORD_BITS) ? ((uint64_t)1 << (map->width % WORD_BITS)) - 1 : ~(uint64_t)0;
+    for(int y = 0; y < map->height; y++)
+    {
+        for(int w = 0; w < stride; w++)
+        {
+            uint64_t walls = 0;
+            if(map->format & MAP_PACKED)
+            {
+                walls = map->walls[(size_t)y * stride + w];
+            }
+            else
+            {
+                for(int i = 0, x = w * WORD_BITS; i < WORD_BITS && x < map->width; i++, x++)
+                {
+                    walls |= (uint64_t)(MapGetUnchecked(map, x, y) == WALL) << i;
+                }
+            }
+            closed[(size_t)y * stride + w] = walls | ~((w == stride - 1) ? lastMask : ~(uint64_t)0);
+        }
+    }
+
+    // Seed the worklist with the dead ends of the unfilled map: a cell has two open neighbours
+    // when both of one axis are open or one of each axis is
+    Queue queue;
+    if(!Queue_namespace.Init(&queue, sizeof(uint32_t), map->width + map->height))
+    {
+        return -1;
+    }
+    BOOL running = TRUE;
+    for(int y = 0; y < map->height && running; y++)
+    {
+        for(int w = 0; w < stride && running; w++)
+        {
+            size_t index = (size_t)y * stride + w;
+            uint64_t open = ~closed[index];
+            uint64_t north = (y > 0) ? ~closed[index - stride] : 0;
+            uint64_t south = (y + 1 < map->height) ? ~closed[index + stride] : 0;
+            uint64_t east = (open >> 1) | ((w + 1 < stride) ? ~closed[index + 1] << (WORD_BITS - 1) : 0);
+            uint64_t west = (open << 1) | ((w > 0) ? ~closed[index - 1] >> (WORD_BITS - 1) : 0);
+            uint64_t two = (north & south) | (east & west) | ((north | south) & (east | west));
+            uint64_t dead = open & ~two;
+            while(dead && running)
+            {
+                uint32_t cell = (uint32_t)y * map->width + w * WORD_BITS + __builtin_ctzll(dead);
+                running = Queue_namespace.Push(&queue, &cell);
+                dead &= dead - 1;
+            }
+        }
+    }
+
+    // Fill the dead ends, a filled cell can leave its only open neighbour a dead end in turn
+    long long filled = 0;
+    uint32_t start = (uint32_t)map->start;
+    uint32_t end = (uint32_t)(map->height - 1) * map->width + map->end;
+    uint32_t cell;
+    while(running && Queue_namespace.Pop(&queue, &cell))
+    {
+        int x = cell % map->width;
+        int y = cell / map->width;
+        if(cell == start || cell == end || TestBit(closed, stride, x, y))
+        {
+            continue;
+        }
+        int openCount = 0;
+        uint32_t next = 0;
+        for(int i = 0; i < 4; i++)
+        {
+            int nx = x + offsets[i][0];
+            int ny = y + offsets[i][1];
+            if(MapInBounds(map, nx, ny) && !TestBit(closed, stride, nx, ny))
+            {
+                openCount++;
+                next = (uint32_t)ny * map->width + nx;
+            }
+        }
+        if(openCount <= 1)
+        {
+            closed[(size_t)y * stride + x / WORD_BITS] |= (uint64_t)1 << (x % WORD_BITS);
+            filled++;
+            running = openCount == 0 || Queue_namespace.Push(&queue, &next);
+        }
+    }
+    Queue_namespace.Destroy(&queue);
+    return running ? filled : -1;
+}
+
+/*
+    Wall in the dead ends of the map, see FillPlane, so any solver run afterwards searches only
+    the cells that can be on a path between the start and end points.
+    Only the filled cells are written, as WALL through SetCell, which moves the map revision.
+    PATH and other values of the cells left open are kept
+    stats = receives the number of cells filled in expanded, can be NULL
+    Return FALSE if memory ran out, the map is left as it was
+*/
+static BOOL FillDeadEnds(Map * map, SolverStats * stats)
+{
+    int stride = (map->width + WORD_BITS - 1) / WORD_BITS;
+    size_t words = (size_t)stride * map->height;
+    ArenaMark mark = map->arena ? Arena_namespace.Mark(map->arena) : 0;
+    BOOL owned;
+    uint64_t * closed = (uint64_t *)ScratchAlloc(map, words * sizeof(uint64_t), &owned);
+    long long filled = closed ? FillPlane(map, closed, stride) : -1;
+    uint64_t lastMask = (map->width % WORD_BITS) ? ((uint64_t)1 << (map->width % WORD_BITS)) - 1 : ~(uint64_t)0;
+    for(int y = 0; y < map->height && filled > 0; y++)
+    {
+        for(int w = 0; w < stride; w++)
+        {
+            uint64_t walls = closed[(size_t)y * stride + w] & ((w == stride - 1) ? lastMask : ~(uint64_t)0);
+            uint64_t added = walls & ~Map_namespace.GetRowWord(map, y, w);
+            while(added)
+            {
+                Map_namespace.SetCell(map, w * WORD_BITS + __builtin_ctzll(added), y, WALL);
+                added &= added - 1;
+            }
+        }
+    }
+    if(stats && filled >= 0)
+    {
+        stats->expanded = (size_t)filled;
+    }
+    if(owned)
+    {
+        free(closed);
+    }
+    if(map->arena)
+    {
+        Arena_namespace.Reset(map->arena, mark);
+    }
+    return filled >= 0;
+}
+
+/*
+    Solve the map by dead end filling: on a perfect maze only the path is left open afterwards.
+    The open cells left over from loops and rooms are searched with CompactSearch, dead ends
+    never lie on a path between the start and end points so it is still a shortest path.
+    The walls of the map are not changed, the filled cells are kept in a scratch plane
+    stats = receives the nodes expanded by the search, can be NULL
+    Return FALSE if memory ran out or the end point cannot be reached
+*/
+static BOOL SolveFilling(Map * map, SolverStats * stats)
+{
+    if(!EndpointsOpen(map))
+    {
+        return FALSE;
+    }
+    int stride = (map->width + WORD_BITS - 1) / WORD_BITS;
+    size_t words = (size_t)stride * map->height;
+    ArenaMark mark = map->arena ? Arena_namespace.Mark(map->arena) : 0;
+    BOOL owned;
+    uint64_t * closed = (uint64_t *)ScratchAlloc(map, words * sizeof(uint64_t), &owned);
+    BOOL found = closed && FillPlane(map, closed, stride) >= 0 && CompactSearch(map, closed, stride, stats);
+    if(owned)
+    {
+        free(closed);
+    }
+    if(map->arena)
+    {
+        Arena_namespace.Reset(map->arena, mark);
+    }
+    return found;
+}
+
+/*
+    Walk back from end to the start of a weighted search, always to a neighbour whose cost plus the
+    cost of entering the current cell gives the current cell's cost, preferring N, S, E, W
+    total  = cost of every reached cell plus one, 0 where the search did not reach
+    path   = receives the cells from start to end, can be NULL
+    output = map to mark the cells on with PATH, can be NULL
+    Return the number of cells of the path
+*/
+static int TraceWeighted(const Map * map, const uint32_t * total, Node end, Node * path, Map * output)
+{
+    static const int offsets[4][2] = {{0, -1}, {0, 1}, {1, 0}, {-1, 0}}; // N, S, E, W
+    int length = 0;
+    // First walk counts the cells, the second writes them from the end backwards
+    for(int pass = 0; pass < 2; pass++)
+    {
+        int x = end.x;
+        int y = end.y;
+        int position = length;
+        while(TRUE)
+        {
+            if(pass == 0)
+            {
+                length++;
+            }
+            else
+            {
+                position--;
+                if(path)
+                {
+                    path[position].x = x;
+                    path[position].y = y;
+                }
+                if(output)
+                {
+                    MapSetUnchecked(output, x, y, PATH);
+                }
+            }
+            uint32_t cost = total[(size_t)y * map->width + x];
+            if(cost == 1)
+            {
+                break; // The start
+            }
+            uint32_t previous = cost - MapCost(map, x, y);
+            for(int i = 0; i < 4; i++)
+            {
+                int nx = x + offsets[i][0];
+                int ny = y + offsets[i][1];
+                if(MapInBounds(map, nx, ny) && total[(size_t)ny * map->width + nx] == previous)
+                {
+                    x = nx;
+                    y = ny;
+                    break;
+                }
+            }
+        }
+        if(!path && !output)
+        {
+            break;
+        }
+    }
+    return length;
+}
+
+/*
+    Search a map with a cost plane breadth first by cost, with Dial's bucket queue: one bucket per
+    pending cost, kept in a ring as no cell is queued more than MAP_MAX_COST ahead of the cheapest
+    Costs are paid on entering a cell, so every step into a cell costs the same and the first time
+    a cell is reached is already its cheapest: cells are queued once and never moved between buckets,
+    which keeps the search linear in the cells reached plus the largest cost
+    total = receives the cost of every reached cell plus one, 0 elsewhere. width * height entries, zeroed
+    arena = arena for the scratch memory, NULL for malloc
+    stats = receives the work done, can be NULL
+    Return FALSE if memory ran out or end cannot be reached from start
+*/
+static BOOL FloodWeighted(const Map * map, Node start, Node end, uint32_t * total, Arena * arena, SolverStats * stats)
+{
+    static const int offsets[4][2] = {{0, -1}, {0, 1}, {1, 0}, {-1, 0}}; // N, S, E, W
+    if(!CellWalkable(map, start.x, start.y) || !CellWalkable(map, end.x, end.y))
+    {
+        return FALSE;
+    }
+    BOOL owned;
+    uint32_t * next = (uint32_t *)ScratchAllocArena(arena, (size_t)map->width * map->height * sizeof(uint32_t), &owned);
+    if(!next)
+    {
+        return FALSE;
+    }
+    uint32_t heads[DIAL_BUCKETS];
+    for(int i = 0; i < DIAL_BUCKETS; i++)
+    {
+        heads[i] = DIAL_EMPTY;
+    }
+
+    uint32_t startCell = (uint32_t)start.y * map->width + start.x;
+    uint32_t endCell = (uint32_t)end.y * map->width + end.x;
+    total[startCell] = 1;
+    next[startCell] = DIAL_EMPTY;
+    heads[0] = startCell;
+    size_t queued = 1;
+    size_t expanded = 0;
+    uint32_t cost = 0;
+    BOOL found = FALSE;
+    while(queued && !found)
+    {
+        uint32_t * bucket = &heads[cost % DIAL_BUCKETS];
+        if((*bucket) == DIAL_EMPTY)
+        {
+            cost++;
+            continue;
+        }
+        uint32_t cell = (*bucket);
+        (*bucket) = next[cell];
+        queued--;
+        if(cell == endCell)
+        {
+            found = TRUE;
+            break;
+        }
+        expanded++;
+        int x = cell % map->width;
+        int y = cell / map->width;
+        for(int i = 0; i < 4; i++)
+        {
+            int nx = x + offsets[i][0];
+            int ny = y + offsets[i][1];
+            size_t index = (size_t)ny * map->width + nx;
+            if(CellWalkable(map, nx, ny) && !total[index])
+            {
+                uint32_t nextCost = cost + MapCost(map, nx, ny);
+                total[index] = nextCost + 1;
+                next[index] = heads[nextCost % DIAL_BUCKETS];
+                heads[nextCost % DIAL_BUCKETS] = (uint32_t)index;
+                queued++;
+            }
+        }
+    }
+    if(owned)
+    {
+        free(next);
+    }
+    if(stats)
+    {
+        stats->expanded = expanded;
+    }
+    return found;
+}
+
+/*
+    Find the cheapest path between two cells of a map with a cost plane, without writing to the map
+    Maps without a cost plane cost 1 per cell, giving the same lengths as FindPath
+    path     = receives the cells from start to end if the path fits, can be NULL to only get the length
+    capacity = number of nodes path can hold
+    cost     = receives the total cost of the cells entered after the start, can be NULL
+    arena    = arena for the scratch memory, reset before returning. NULL for malloc
+    stats    = receives the work done, can be NULL
+    Return the number of cells of the path including both ends, or 0 if out of memory or unreachable
+*/
+static int FindPathWeighted(const Map * map, Node start, Node end, Node * path, int capacity, uint32_t * cost, Arena * arena, SolverStats * stats)
+{
+    if(!MapInBounds(map, start.x, start.y) || !MapInBounds(map, end.x, end.y))
+    {
+        return 0;
+    }
+    ArenaMark mark = arena ? Arena_namespace.Mark(arena) : 0;
+    BOOL owned;
+    uint32_t * total = (uint32_t *)ScratchAllocArena(arena, (size_t)map->width * map->height * sizeof(uint32_t), &owned);
+    int length = 0;
+    if(total && FloodWeighted(map, start, end, total, arena, stats))
+    {
+        length = TraceWeighted(map, total, end, NULL, NULL);
+        if(path && length <= capacity)
+        {
+            TraceWeighted(map, total, end, path, NULL);
+        }
+        if(cost)
+        {
+            (*cost) = total[(size_t)end.y * map->width + end.x] - 1;
+        }
+    }
+    if(owned)
+    {
+        free(total);
+    }
+    if(arena)
+    {
+        Arena_namespace.Reset(arena, mark);
+    }
+    return length;
+}
+
+/*
+    Solve a map with a cost plane, marking its cheapest path with PATH cells
+    stats = receives the work done, can be NULL
+    Return FALSE if memory ran out or the end point cannot be reached, the map is left unsolved
+*/
+static BOOL SolveWeighted(Map * map, SolverStats * stats)
+{
+    if((map->format & MAP_PACKED) && !map->marks)
+    {
+        return FALSE;
+    }
+    Node start = {map->start, 0};
+    Node end = {map->end, map->height - 1};
+    ArenaMark mark = map->arena ? Arena_namespace.Mark(map->arena) : 0;
+    BOOL owned;
+    uint32_t * total = (uint32_t *)ScratchAllocArena(map->arena, (size_t)map->width * map->height * sizeof(uint32_t), &owned);
+    BOOL found = total && FloodWeighted(map, start, end, total, map->arena, stats);
+    if(found)
+    {
+        TraceWeighted(map, total, end, NULL, map);
+    }
+    if(owned)
+    {
+        free(total);
+    }
+    if(map->arena)
+    {
+        Arena_namespace.Reset(map->arena, mark);
+    }
+    return found;
+}
+
+// Every solver, by the name used to pick it
+static const SolverInfo solvers[] =
+{
+    {"bfs",            Solve,               MAP_CELLS},
+    {"bitboard",       SolveBitboard,       MAP_PACKED | MAP_SCRATCH},
+    {"bidirectional",  SolveBidirectional,  MAP_CELLS},
+    {"astar",          SolveAStar,          MAP_CELLS},
+    {"jps",            SolveJumpPoint,      MAP_CELLS},
+    {"parallel",       SolveParallelShared, MAP_CELLS},
+    {"dijkstra",       SolveWeighted,       MAP_CELLS},
+    {"compact",        SolveCompact,        MAP_PACKED | MAP_SCRATCH},
+    {"filling",        SolveFilling,        MAP_PACKED | MAP_SCRATCH},
+};
+
+/*
+    Find a solver by name
+    Return NULL for an unknown name
+*/
+static const SolverInfo * Find(const char * name)
+{
+    for(size_t i = 0; i < sizeof(solvers) / sizeof(solvers[0]); i++)
+    {
+        if(strcmp(solvers[i].name, name) == 0)
+        {
+            return &solvers[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+    Return the table of every solver
+    count = receives the number of solvers
+*/
+static const SolverInfo * List(int * count)
+{
+    (*count) = (int)(sizeof(solvers) / sizeof(solvers[0]));
+    return solvers;
+}
+
+/*
+    Return the number of PATH cells on a solved map
+*/
+static int PathLength(Map * map)
+{
+    int length = 0;
+    for(int i = 0; i < map->width; i++)
+    {
+        for(int ii = 0; ii < map->height; ii++)
+        {
+            length += MapGetUnchecked(map, i, ii) == PATH;
+        }
+    }
+    return length;
+}
+
+// Solver namespace struct, contains function pointers related to solving maps
+const struct solver_namespace Solver_namespace =
+{
+    .Solve = Solve,
+    .SolveBitboard = SolveBitboard,
+    .SolveBidirectional = SolveBidirectional,
+    .SolveAStar = SolveAStar,
+    .SolveJumpPoint = SolveJumpPoint,
+    .SolveParallel = SolveParallel,
+    .SolveWeighted = SolveWeighted,
+    .SolveCompact = SolveCompact,
+    .SolveFilling = SolveFilling,
+    .FillDeadEnds = FillDeadEnds,
+    .ExpandNode = ExpandNode,
+    .FindPath = FindPath,
+    .FindPathWeighted = FindPathWeighted,
+    .FloodFill = FloodFill,
+    .PathLength = PathLength,
+    .Find = Find,
+    .List = List
+};
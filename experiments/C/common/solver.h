@@ -0,0 +1,70 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "common.h"
+#include "queue.h"
+#include "pool.h"
+
+/*
+    Struct representing a node on a map
+    x = x coordinate
+    y = y coordinate
+*/
+typedef struct Node
+{
+    int x;
+    int y;
+} Node;
+
+/*
+    Work done by a solver, for comparing algorithms
+*/
+typedef struct SolverStats
+{
+    size_t expanded;    // Nodes taken off the frontier and expanded
+} SolverStats;
+
+/*
+    A solver: marks a shortest path from the start to the end point with PATH cells (the cheapest one,
+    for the weighted solver on maps with a cost plane)
+    stats = receives the work done, can be NULL
+    Return FALSE if memory ran out or the end point cannot be reached
+*/
+typedef BOOL (* SolveFunction)(Map * map, SolverStats * stats);
+
+/*
+    Entry of the solver table, to pick a solver by name
+    format = map format the solver works best on, to load maps with
+*/
+typedef struct SolverInfo
+{
+    const char * name;
+    SolveFunction solve;
+    int format;
+} SolverInfo;
+
+typedef struct solver_namespace
+{
+    BOOL (* Solve)(Map * map, SolverStats * stats);
+    BOOL (* SolveBitboard)(Map * map, SolverStats * stats);
+    BOOL (* SolveBidirectional)(Map * map, SolverStats * stats);
+    BOOL (* SolveAStar)(Map * map, SolverStats * stats);
+    BOOL (* SolveJumpPoint)(Map * map, SolverStats * stats);
+    BOOL (* SolveParallel)(Map * map, Pool * pool, SolverStats * stats);
+    BOOL (* SolveWeighted)(Map * map, SolverStats * stats);
+    BOOL (* SolveCompact)(Map * map, SolverStats * stats);
+    BOOL (* SolveFilling)(Map * map, SolverStats * stats);
+    BOOL (* FillDeadEnds)(Map * map, SolverStats * stats);
+    BOOL (* ExpandNode)(Map * map, Queue * queue, Node node, unsigned int distance, BOOL * pushed);
+    int (* FindPath)(const Map * map, Node start, Node end, Node * path, int capacity, struct Arena * arena, SolverStats * stats);
+    int (* FindPathWeighted)(const Map * map, Node start, Node end, Node * path, int capacity, uint32_t * cost,
+        struct Arena * arena, SolverStats * stats);
+    BOOL (* FloodFill)(const Map * map, Node source, uint32_t * distance, struct Arena * arena);
+    int (* PathLength)(Map * map);
+    const SolverInfo * (* Find)(const char * name);
+    const SolverInfo * (* List)(int * count);
+} solver_namespace;
+
+extern const struct solver_namespace Solver_namespace;
+
+#endif // SOLVER_H
@@ -17,7 +17,7 @@
 //        ;for(j=0;6.28>j;j+=0.07)for(i=0;6.28
 //       >i;i+=0.02){float c=sin(i),d=cos(j),e=
 //       sin(A),f=sin(j),g=cos(A),h=d+2,D=1/(c*
-//       h*e+f*g+5),l=cos      (i),m=cos(B),n=s\
+//       h*e+f*g+5),l=cos      (i),m=cos(B),n=s
 //      in(B),t=c*h*g-f*        e;int x=40+30*D*
 //      (l*h*m-t*n),y=            12+15*D*(l*h*n
 //      +t*m),o=x+80*y,          N=8*((f*e-c*d*g
@@ -37,6 +37,45 @@
 #include <unistd.h>
 #include <math.h>
 
+/*
+	Render one frame of the original donut into the character buffer b
+	A, B = rotation angles
+	z    = depth buffer, 1760 floats
+*/
+void OriginalFrame(float A, float B, char * b, float * z)
+{
+	memset(b, 32, 1760);
+	memset(z, 0, 7040);
+	for(float i = 0; i < 6.28; i += 0.07)
+	{
+		for(float ii = 0; ii < 6.28; ii += 0.02)
+		{
+			float c = sin(ii);
+			float d = cos(i);
+			float e = sin(A);
+			float f = sin(i);
+			float g = cos(A);
+			float h = d + 2;
+			float D = 1 / (c * h * e + f * g + 5);
+			float l = cos(ii);
+			float m = cos(B);
+			float n = sin(B);
+			float t = c * h * g - f * e;
+			
+			int x = 40 + 30 * D * (l * h * m - t * n);
+			int y = 12 + 15 * D * (l * h * n + t * m);
+			int o = x + 80 * y;
+			int N = 8 * (( f * e - c * d * g) * m - c * d * e - f * g - l * d * n);
+			
+			if( 22 > y && y > 0 && x > 0 && 80 > x && D > z[o])
+			{
+				z[o] = D;
+				b[o] = ".,-~:;=!*#$@"[N > 0 ? N : 0];
+			}
+		}
+	}
+}
+
 void Original(void)
 {
 	float A = 0;
@@ -46,36 +85,7 @@ void Original(void)
 	printf("\x1b[2J");
 	for(;;)
 	{
-		memset(b, 32, 1760);
-		memset(z, 0, 7040);
-		for(float i = 0; i < 6.28; i += 0.07)
-		{
-			for(float ii = 0; ii < 6.28; ii += 0.02)
-			{
-				float c = sin(ii);
-				float d = cos(i);
-				float e = sin(A);
-				float f = sin(i);
-				float g = cos(A);
-				float h = d + 2;
-				float D = 1 / (c * h * e + f * g + 5);
-				float l = cos(ii);
-				float m = cos(B);
-				float n = sin(B);
-				float t = c * h * g - f * e;
-				
-				int x = 40 + 30 * D * (l * h * m - t * n);
-				int y = 12 + 15 * D * (l * h * n + t * m);
-				int o = x + 80 * y;
-				int N = 8 * (( f * e - c * d * g) * m - c * d * e - f * g - l * d * n);
-				
-				if( 22 > y && y > 0 && x > 0 && 80 > x && D > z[o])
-				{
-					z[o] = D;
-					b[o] = ".,-~:;=!*#$@"[N > 0 ? N : 0];
-				}
-			}
-		}
+		OriginalFrame(A, B, b, z);
 			
 		printf("\x1b[H");
 		for(int i = 0 ; i < 1761; i++)
@@ -93,11 +103,58 @@ void Original(void)
 		_ = x;								\
 		x -= mul * y >> shift; 				\
 		y += mul * _ >> shift;				\
-		_ = 3145728 - x * x - y * y >> 11;	\
+		_ = (3145728 - x * x - y * y) >> 11;	\
 		x = x * _ >> 10;					\
 		y = y * _ >> 10;					\
 	} while(0) 		 					
 
+/*
+	Render one frame of the optimised donut into the character buffer b
+	sA, cA, sB, cB = sine and cosine of the rotation angles, scaled by 1024
+	z              = depth buffer, 1760 bytes
+*/
+void OptimisedFrame(int sA, int cA, int sB, int cB, int8_t * b, int8_t * z)
+{
+	int _  = 0;
+	memset(b, 32, 1760);
+	memset(z, 127, 1760);
+	int sj = 0;
+	int cj = 1024;
+	for(int i = 0; i < 90; i++)
+	{
+		int si = 0;
+		int ci = 1024;
+		for(int ii = 0; ii < 324; ii++)
+		{
+			int R1 = 1;
+			int R2 = 2048;
+			int K2 = 5120 * 1024;
+
+			int x0 = R1 * cj + R2;
+			int x1 = ci * x0 >> 10;
+			int x2 = cA * sj >> 10;
+			int x3 = si * x0 >> 10;
+			int x4 = R1 * x2 - (sA * x3 >> 10);
+			int x5 = sA * sj >> 10;
+			int x6 = K2 + R1 * 1024 * x5 + cA * x3;
+			int x7 = cj * si >> 10;
+			int x = 40 + 30 * (cB * x1 - sB * x4) / x6;
+			int y = 12 + 15 * (cB * x4 + sB * x1) / x6;
+			int N = (((-cA * x7 - cB * ((-sA * x7 >> 10) + x2) - ci * (cj * sB >> 10)) >> 10) - x5) >> 7;
+
+			int o = x + 80 * y;
+			int8_t zz = (x6 - K2) >> 15;
+			if(22 > y && y > 0 && x > 0 && 80 > x && zz < z[o])
+			{
+				z[o] = zz;
+				b[o] = ".,-~:;=!*#$@"[N > 0 ? N : 0];
+			}
+			ROTATE(5, 8, ci, si);
+		}
+		ROTATE(9, 7, cj, sj);
+	}
+}
+
 void Optimised(void)
 {
 	int8_t b[1760], z[1760];
@@ -110,43 +167,7 @@ void Optimised(void)
 
 	for(;;)
 	{
-		memset(b, 32, 1760);
-		memset(z, 127, 1760);
-		int sj = 0;
-		int cj = 1024;
-		for(int i = 0; i < 90; i++)
-		{
-			int si = 0;
-			int ci = 1024;
-			for(int ii = 0; ii < 324; ii++)
-			{
-				int R1 = 1;
-				int R2 = 2048;
-				int K2 = 5120 * 1024;
-
-				int x0 = R1 * cj + R2;
-				int x1 = ci * x0 >> 10;
-				int x2 = cA * sj >> 10;
-				int x3 = si * x0 >> 10;
-				int x4 = R1 * x2 - (sA * x3 >> 10);
-				int x5 = sA * sj >> 10;
-				int x6 = K2 + R1 * 1024 * x5 + cA * x3;
-				int x7 = cj * si >> 10;
-				int x = 40 + 30 * (cB * x1 - sB * x4) / x6;
-				int y = 12 + 15 * (cB * x4 + sB * x1) / x6;
-				int N = (-cA * x7 - cB * ((-sA * x7 >> 10) + x2) - ci * (cj * sB >> 10) >> 10) - x5 >> 7;
-
-				int o = x + 80 * y;
-				int8_t zz = (x6 - K2) >> 15;
-				if(22 > y && y > 0 && x > 0 && 80 > x && zz < z[o])
-				{
-					z[o] = zz;
-					b[o] = ".,-~:;=!*#$@"[N > 0 ? N : 0];
-				}
-				ROTATE(5, 8, ci, si);
-			}
-			ROTATE(9, 7, cj, sj);
-		}
+		OptimisedFrame(sA, cA, sB, cB, b, z);
 		for(int i = 0; i < 1761; i++)
 		{	
 			putchar(i % 80 ? b[i] : 10);
@@ -158,6 +179,63 @@ void Optimised(void)
 	}
 }
 
+#ifdef BENCHMARK
+#include "./common/bench.h"
+
+/*
+	Buffers and angles of the frame benchmarks
+*/
+typedef struct DonutBench
+{
+	char b[1760];
+	float z[1760];
+	int8_t ib[1760];
+	int8_t iz[1760];
+	float A, B;				// Rotation angles of both versions
+	int sA, cA, sB, cB;		// The same angles as the optimised version takes them, scaled by 1024
+} DonutBench;
+
+void OriginalBench(void * context)
+{
+	DonutBench * bench = (DonutBench *)context;
+	OriginalFrame(bench->A, bench->B, bench->b, bench->z);
+}
+
+void OptimisedBench(void * context)
+{
+	DonutBench * bench = (DonutBench *)context;
+	OptimisedFrame(bench->sA, bench->cA, bench->sB, bench->cB, bench->ib, bench->iz);
+}
+
+/*
+	Benchmark one frame of each version, without printing it
+	donut [benchmark options]
+*/
+int main(int argc, char * argv[])
+{
+	if(Bench_namespace.Init(argc, argv, "donut") < 0)
+	{
+		return 1;
+	}
+	DonutBench bench;
+	bench.A  = 1.f;
+	bench.B  = 0.5f;
+	bench.sA = (int)(1024 * sin(bench.A));
+	bench.cA = (int)(1024 * cos(bench.A));
+	bench.sB = (int)(1024 * sin(bench.B));
+	bench.cB = (int)(1024 * cos(bench.B));
+	const Benchmark benchmarks[] =
+	{
+		{"original_frame",  NULL, OriginalBench,  &bench, 1},
+		{"optimised_frame", NULL, OptimisedBench, &bench, 1},
+	};
+	for(size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++)
+	{
+		Bench_namespace.Run(&benchmarks[i]);
+	}
+	return Bench_namespace.Finish();
+}
+#else
 int main(int argc, char * argv[])
 {
 	int selection = 0;
@@ -181,4 +259,5 @@ int main(int argc, char * argv[])
 		printf("2 to run optimised version:\n");
 	}
 	return 0;
-}
\ No newline at end of file
+}
+#endif // BENCHMARK
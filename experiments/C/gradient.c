@@ -17,6 +17,14 @@
 
 #define ARRAY_SIZE(x)   (sizeof(x) / sizeof(x[0]))
 
+// MSVC provides __min/__max, other compilers do not
+#ifndef __min
+#define __min(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+#ifndef __max
+#define __max(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
 /*
 RGB structure representing red, green and blue
 */
@@ -230,6 +238,68 @@ void DrawColourHSL(const HSL hsl, const int x, const int w, SDL_Renderer * pRend
     SDL_RenderFillRect(pRenderer, &rect);
 }
 
+#ifdef BENCHMARK
+#include <stdlib.h>
+#include "./common/bench.h"
+
+#define BENCH_COLOURS 4096
+
+/*
+Random colours to convert and interpolate
+*/
+typedef struct ColourBench
+{
+    HSL colours[BENCH_COLOURS];
+    RGB out;
+    HSL mixed;
+    int next;
+} ColourBench;
+
+void ConvertColour(void * context)
+{
+    ColourBench * bench = (ColourBench *)context;
+    HSL2RGB(bench->colours[bench->next], &bench->out);
+    bench->next = (bench->next + 1) % BENCH_COLOURS;
+}
+
+void InterpolateColour(void * context)
+{
+    ColourBench * bench = (ColourBench *)context;
+    int next = (bench->next + 1) % BENCH_COLOURS;
+    bench->mixed = InterpolateHSL(bench->colours[bench->next], bench->colours[next], (next % 64) / 64.0);
+    bench->next = next;
+}
+
+/*
+Benchmark the colour conversion and interpolation used for every gradient step
+gradient [benchmark options]
+*/
+int main(int argc, char *argv[])
+{
+    if(Bench_namespace.Init(argc, argv, "gradient") < 0)
+    {
+        return 1;
+    }
+    static ColourBench bench;
+    srand(1);
+    for(int i = 0; i < BENCH_COLOURS; i++)
+    {
+        RGB rgb = {rand() % 256, rand() % 256, rand() % 256};
+        RGB2HSL(rgb, &bench.colours[i]);
+    }
+    const Benchmark benchmarks[] =
+    {
+        {"hsl2rgb",         NULL, ConvertColour,     &bench, BENCH_COLOURS},
+        {"interpolate_hsl", NULL, InterpolateColour, &bench, BENCH_COLOURS},
+    };
+    for(size_t i = 0; i < ARRAY_SIZE(benchmarks); i++)
+    {
+        bench.next = 0;
+        Bench_namespace.Run(&benchmarks[i]);
+    }
+    return Bench_namespace.Finish();
+}
+#else
 int main(int argc, char *argv[])
 {
     SDL_Window   * pWindow   = NULL;
@@ -279,7 +349,7 @@ int main(int argc, char *argv[])
         // Original colours are not drawn
         int x = 0;
         int w = COLOUR_SIZE;
-        for(int i = 1; i < ARRAY_SIZE(inHSL); i++)
+        for(size_t i = 1; i < ARRAY_SIZE(inHSL); i++)
         {
             int steps = TOTAL_COLOURS / (ARRAY_SIZE(inHSL) - 1);
             for(int ii = 0; ii < steps; ii++)
@@ -310,4 +380,5 @@ int main(int argc, char *argv[])
     }
     SDL_Quit();
     return 0;
-}
\ No newline at end of file
+}
+#endif // BENCHMARK
@@ -0,0 +1,262 @@
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "./common/common.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define DEFAULT_SIZE    2048
+#define RAY_COUNT       200000
+
+/*
+    Struct representing a node on a map
+*/
+typedef struct Node
+{
+    int x;
+    int y;
+} Node;
+
+/*
+    Layouts under comparison
+*/
+typedef struct Layout
+{
+    const char * name;
+    int format;
+} Layout;
+
+static const Layout LAYOUTS[] =
+{
+    {"column-major", MAP_CELLS},
+    {"tiled-8x8",    MAP_TILED},
+    {"morton-64",    MAP_MORTON},
+    {"packed",       MAP_PACKED},
+};
+
+/*
+    Open a hardware cache-miss counter for this thread
+    Return the file descriptor, or -1 if counters are not available (e.g. in a container)
+*/
+int OpenCacheCounter(void)
+{
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type           = PERF_TYPE_HARDWARE;
+    attr.size           = sizeof(attr);
+    attr.config         = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled       = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+/*
+    Start counting cache misses
+*/
+void StartCounter(int fd)
+{
+#ifdef __linux__
+    if(fd >= 0)
+    {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+/*
+    Stop counting and return the number of cache misses, or -1 if not available
+*/
+long long StopCounter(int fd)
+{
+    long long count = -1;
+#ifdef __linux__
+    if(fd >= 0)
+    {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if(read(fd, &count, sizeof(count)) != sizeof(count))
+        {
+            count = -1;
+        }
+    }
+#endif
+    return count;
+}
+
+/*
+    Return monotonic time in milliseconds
+*/
+double Now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+/*
+    Fill the map with a random open maze: walls around the border and scattered walls inside
+    seed = random seed, so every layout gets the same map
+*/
+void GenerateMap(Map * map, unsigned int seed)
+{
+    srand(seed);
+    for(int y = 0; y < map->height; y++)
+    {
+        for(int x = 0; x < map->width; x++)
+        {
+            BOOL border = (x == 0 || y == 0 || x == map->width - 1 || y == map->height - 1);
+            Map_namespace.SetCell(map, x, y, (border || rand() % 100 < 30) ? WALL : FREE);
+        }
+    }
+    map->start  = map->width / 2;
+    map->end    = map->width / 2;
+    Map_namespace.SetCell(map, map->start, 1, FREE);
+}
+
+/*
+    Breadth first flood from the start point, the same access pattern as the maze solver
+    Marks visited cells with PATH and returns the number of visited cells
+*/
+long FloodKernel(Map * map)
+{
+    Node * queue = (Node *)malloc((size_t)map->width * map->height * sizeof(Node));
+    long head = 0;
+    long tail = 0;
+    queue[tail].x = map->start;
+    queue[tail++].y = 1;
+    Map_namespace.SetCell(map, map->start, 1, PATH);
+    while(head < tail)
+    {
+        Node node = queue[head++];
+        int dx[4] = {0, 0, 1, -1};
+        int dy[4] = {-1, 1, 0, 0};
+        for(int i = 0; i < 4; i++)
+        {
+            int x = node.x + dx[i];
+            int y = node.y + dy[i];
+            if(Map_namespace.GetCell(map, x, y) == FREE)
+            {
+                Map_namespace.SetCell(map, x, y, PATH);
+                queue[tail].x = x;
+                queue[tail++].y = y;
+            }
+        }
+    }
+    free(queue);
+    return tail;
+}
+
+/*
+    Cast rays in random directions from random free cells until they hit a wall, like the raycaster's DDA
+    Returns the total number of cells stepped through
+*/
+long RayKernel(Map * map)
+{
+    long steps = 0;
+    srand(7);
+    for(int i = 0; i < RAY_COUNT; i++)
+    {
+        double posX = 1 + rand() % (map->width - 2) + 0.5;
+        double posY = 1 + rand() % (map->height - 2) + 0.5;
+        double angle = (rand() % 3600) / 3600.0 * 6.283185;
+        double rayDirX = cos(angle);
+        double rayDirY = sin(angle);
+        int mapX = (int)posX;
+        int mapY = (int)posY;
+        double deltaDistX = fabs(1.0 / rayDirX);
+        double deltaDistY = fabs(1.0 / rayDirY);
+        int stepX = (rayDirX < 0) ? -1 : 1;
+        int stepY = (rayDirY < 0) ? -1 : 1;
+        double sideDistX = (rayDirX < 0) ? (posX - mapX) * deltaDistX : (mapX + 1.0 - posX) * deltaDistX;
+        double sideDistY = (rayDirY < 0) ? (posY - mapY) * deltaDistY : (mapY + 1.0 - posY) * deltaDistY;
+
+        // Walk through PATH/FREE cells alike, so rays travel far through the flooded map
+        while(Map_namespace.GetCell(map, mapX, mapY) != WALL)
+        {
+            if(sideDistX < sideDistY)
+            {
+                sideDistX += deltaDistX;
+                mapX += stepX;
+            }
+            else
+            {
+                sideDistY += deltaDistY;
+                mapY += stepY;
+            }
+            steps++;
+        }
+    }
+    return steps;
+}
+
+/*
+    Read every cell row by row, like SaveMap and the renderers
+    Returns the number of wall cells
+*/
+long ScanKernel(Map * map)
+{
+    long walls = 0;
+    for(int y = 0; y < map->height; y++)
+    {
+        for(int x = 0; x < map->width; x++)
+        {
+            walls += Map_namespace.GetCell(map, x, y) == WALL;
+        }
+    }
+    return walls;
+}
+
+/*
+    Compare run time and cache misses of the solver, raycaster and scan access patterns across map layouts
+    layout_bench [size]
+*/
+int main(int argc, char * argv[])
+{
+    int size = (argc > 1) ? atoi(argv[1]) : DEFAULT_SIZE;
+    long (* kernels[3])(Map *) = {FloodKernel, RayKernel, ScanKernel};
+    const char * names[3] = {"flood", "rays", "scan"};
+
+    int counter = OpenCacheCounter();
+    if(counter < 0)
+    {
+        printf("cache miss counters not available, reporting time only\n");
+    }
+    printf("%-14s %-6s %10s %14s %12s\n", "layout", "kernel", "ms", "cache-misses", "work");
+    for(size_t i = 0; i < sizeof(LAYOUTS) / sizeof(LAYOUTS[0]); i++)
+    {
+        Map map;
+        Map_namespace.InitFormat(&map, size, size, WALL, LAYOUTS[i].format | MAP_SCRATCH);
+        GenerateMap(&map, 1);
+        for(int k = 0; k < 3; k++)
+        {
+            StartCounter(counter);
+            double start = Now();
+            long work = kernels[k](&map);
+            double elapsed = Now() - start;
+            long long misses = StopCounter(counter);
+            printf("%-14s %-6s %10.2f %14lld %12ld\n", LAYOUTS[i].name, names[k], elapsed, misses, work);
+        }
+        Map_namespace.Destroy(&map);
+    }
+#ifdef __linux__
+    if(counter >= 0)
+    {
+        close(counter);
+    }
+#endif
+    return 0;
+}
@@ -0,0 +1,811 @@
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "./common/common.h"
+#include "./common/solver.h"
+#include "./common/bench.h"
+#include "./common/arena.h"
+#include "./common/pool.h"
+#include "./common/cache.h"
+#include "./common/planner.h"
+#include "./common/hpa.h"
+#include "./common/labels.h"
+
+#define DEFAULT_SIZE    1025
+#define TEXT_FILE       "map_bench.txt"
+#define BINARY_FILE     "map_bench.bin"
+#define PAIR_COUNT      16          // Start/end pairs searched at once on the shared maze
+#define PAIR_ARENA_SIZE (16 << 20)  // Scratch memory per thread, in bytes
+
+/*
+    State shared by the map benchmarks
+*/
+typedef struct MapBench
+{
+    Map map;    // Maze to save and solve
+} MapBench;
+
+/*
+    One solver on its own copy of a map, in the format the solver prefers
+*/
+typedef struct SolveBench
+{
+    const SolverInfo * solver;
+    Map map;
+    char name[64];
+} SolveBench;
+
+/*
+    Carve a perfect maze with the binary tree algorithm: every cell on odd coordinates is opened
+    and joined to its north or west neighbour at random
+    size = width and height, odd
+*/
+void GenerateMaze(Map * map, int size)
+{
+    Map_namespace.Init(map, size, size, WALL);
+    SeedRandom(1);
+    for(int y = 1; y < size - 1; y += 2)
+    {
+        for(int x = 1; x < size - 1; x += 2)
+        {
+            MapSetUnchecked(map, x, y, FREE);
+            BOOL north = (y > 1) && (x == 1 || Random() % 2);
+            if(north)
+            {
+                MapSetUnchecked(map, x, y - 1, FREE);
+            }
+            else if(x > 1)
+            {
+                MapSetUnchecked(map, x - 1, y, FREE);
+            }
+        }
+    }
+    map->start  = 1;
+    map->end    = size - 2;
+    MapSetUnchecked(map, map->start, 0, FREE);
+    MapSetUnchecked(map, map->end, size - 1, FREE);
+    Map_namespace.Touch(map); // Written through the inline accessors
+}
+
+/*
+    Fill an open room with walls scattered over one in eight cells, the kind of map where
+    a flood fill visits far more cells than the path needs
+    size = width and height
+*/
+void GenerateRoom(Map * map, int size)
+{
+    Map_namespace.Init(map, size, size, FREE);
+    SeedRandom(1);
+    for(int y = 0; y < size; y++)
+    {
+        for(int x = 0; x < size; x++)
+        {
+            MapSetUnchecked(map, x, y, (Random() % 8) ? FREE : WALL);
+        }
+    }
+    map->start  = 1;
+    map->end    = size - 2;
+    MapSetUnchecked(map, map->start, 0, FREE);
+    MapSetUnchecked(map, map->end, size - 1, FREE);
+    Map_namespace.Touch(map); // Written through the inline accessors
+}
+
+/*
+    Copy a map into a new map of the given format, a row word at a time
+*/
+void CopyMap(Map * to, const Map * from, int format)
+{
+    Map_namespace.InitFormat(to, from->width, from->height, WALL, format);
+    for(int y = 0; y < from->height; y++)
+    {
+        for(int w = 0; w < to->stride; w++)
+        {
+            Map_namespace.SetRowWord(to, y, w, Map_namespace.GetRowWord((Map *)from, y, w));
+        }
+    }
+    to->start   = from->start;
+    to->end     = from->end;
+}
+
+void SaveText(void * context)
+{
+    Map_namespace.SaveMap(&((MapBench *)context)->map, TEXT_FILE);
+}
+
+void LoadText(void * context)
+{
+    (void)context;
+    Map map;
+    if(Map_namespace.LoadMap(&map, TEXT_FILE))
+    {
+        Map_namespace.Destroy(&map);
+    }
+}
+
+void SaveBinary(void * context)
+{
+    Map_namespace.SaveMapBinary(&((MapBench *)context)->map, BINARY_FILE);
+}
+
+void LoadBinary(void * context)
+{
+    (void)context;
+    Map map;
+    if(Map_namespace.LoadMapBinary(&map, BINARY_FILE, MAP_CELLS))
+    {
+        Map_namespace.Destroy(&map);
+    }
+}
+
+/*
+    Remove the path of the previous solve, so every sample solves the same maze
+*/
+void ClearPath(void * context)
+{
+    Map * map = (Map *)context;
+    for(int x = 0; x < map->width; x++)
+    {
+        for(int y = 0; y < map->height; y++)
+        {
+            if(MapGetUnchecked(map, x, y) == PATH)
+            {
+                MapSetUnchecked(map, x, y, FREE);
+            }
+        }
+    }
+}
+
+void ClearSolve(void * context)
+{
+    ClearPath(&((SolveBench *)context)->map);
+}
+
+void RunSolve(void * context)
+{
+    SolveBench * bench = (SolveBench *)context;
+    bench->solver->solve(&bench->map, NULL);
+}
+
+/*
+    Time every solver on a map, then solve once more to report the nodes each one expanded
+    prefix = prefix of the benchmark names, "solve" on its own is the flood fill
+*/
+void BenchSolvers(const Map * map, const char * prefix)
+{
+    int count;
+    const SolverInfo * solvers = Solver_namespace.List(&count);
+    for(int i = 0; i < count; i++)
+    {
+        SolveBench bench;
+        bench.solver = &solvers[i];
+        CopyMap(&bench.map, map, bench.solver->format);
+        if(strcmp(bench.solver->name, "bfs") == 0)
+        {
+            snprintf(bench.name, sizeof(bench.name), "%s", prefix);
+        }
+        else
+        {
+            snprintf(bench.name, sizeof(bench.name), "%s_%s", prefix, bench.solver->name);
+        }
+        Benchmark benchmark = {bench.name, ClearSolve, RunSolve, &bench, 1};
+        Bench_namespace.Run(&benchmark);
+
+        SolverStats stats = {0};
+        char metric[80];
+        snprintf(metric, sizeof(metric), "%s_expanded", bench.name);
+        ClearPath(&bench.map);
+        if(bench.solver->solve(&bench.map, &stats))
+        {
+            Bench_namespace.Metric(metric, "nodes", (double)stats.expanded);
+        }
+        Map_namespace.Destroy(&bench.map);
+    }
+}
+
+/*
+    Random start/end pairs searched by a pool of threads on one shared, read-only map
+*/
+typedef struct PairBench
+{
+    const Map * map;
+    Node pairs[PAIR_COUNT][2];
+    int lengths[PAIR_COUNT];
+    Arena * arenas;     // One per thread
+    Pool pool;
+} PairBench;
+
+/*
+    Pool task: find the path of one pair, with the scratch memory of the running thread
+*/
+void FindPairPath(void * context, int index, int thread)
+{
+    PairBench * bench = (PairBench *)context;
+    bench->lengths[index] = Solver_namespace.FindPath(bench->map, bench->pairs[index][0], bench->pairs[index][1],
+        NULL, 0, &bench->arenas[thread], NULL);
+}
+
+void FindPairs(void * context)
+{
+    PairBench * bench = (PairBench *)context;
+    Pool_namespace.Run(&bench->pool, PAIR_COUNT, FindPairPath, bench);
+}
+
+/*
+    Time PAIR_COUNT searches between random open cells of the maze, spread over one thread per core
+*/
+void BenchPairs(const Map * map)
+{
+    PairBench bench;
+    bench.map = map;
+    if(!Pool_namespace.Init(&bench.pool, 0))
+    {
+        return;
+    }
+    bench.arenas = (Arena *)calloc(bench.pool.threadCount, sizeof(Arena));
+    for(int i = 0; bench.arenas && i < bench.pool.threadCount; i++)
+    {
+        Arena_namespace.Init(&bench.arenas[i], PAIR_ARENA_SIZE);
+    }
+    // Cells on odd coordinates are always open in the binary tree maze
+    SeedRandom(2);
+    for(int i = 0; i < PAIR_COUNT; i++)
+    {
+        for(int ii = 0; ii < 2; ii++)
+        {
+            bench.pairs[i][ii].x = (Random() % (map->width / 2)) * 2 + 1;
+            bench.pairs[i][ii].y = (Random() % (map->height / 2)) * 2 + 1;
+        }
+    }
+    if(bench.arenas)
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "find_path_%d_pairs_%d_threads", PAIR_COUNT, bench.pool.threadCount);
+        Benchmark benchmark = {name, NULL, FindPairs, &bench, 1};
+        Bench_namespace.Run(&benchmark);
+        for(int i = 0; i < bench.pool.threadCount; i++)
+        {
+            Arena_namespace.Destroy(&bench.arenas[i]);
+        }
+    }
+    free(bench.arenas);
+    Pool_namespace.Destroy(&bench.pool);
+}
+
+/*
+    SolveParallel with a pool of a given size, on its own copy of a map
+*/
+typedef struct ParallelBench
+{
+    Map map;
+    Pool pool;
+} ParallelBench;
+
+void RunParallel(void * context)
+{
+    ParallelBench * bench = (ParallelBench *)context;
+    Solver_namespace.SolveParallel(&bench->map, &bench->pool, NULL);
+}
+
+void ClearParallel(void * context)
+{
+    ClearPath(&((ParallelBench *)context)->map);
+}
+
+/*
+    Time the parallel solver with 1, 2, 4... threads up to one per core, to see how it scales
+    prefix = prefix of the benchmark names
+*/
+void BenchParallel(const Map * map, const char * prefix)
+{
+    int cores = Pool_namespace.CoreCount();
+    for(int threads = 1; threads <= cores; threads = (threads * 2 > cores && threads < cores) ? cores : threads * 2)
+    {
+        ParallelBench bench;
+        if(!Pool_namespace.Init(&bench.pool, threads))
+        {
+            return;
+        }
+        CopyMap(&bench.map, map, MAP_CELLS);
+        char name[64];
+        snprintf(name, sizeof(name), "%s_parallel_%d_threads", prefix, bench.pool.threadCount);
+        Benchmark benchmark = {name, ClearParallel, RunParallel, &bench, 1};
+        Bench_namespace.Run(&benchmark);
+        Map_namespace.Destroy(&bench.map);
+        Pool_namespace.Destroy(&bench.pool);
+    }
+}
+
+/*
+    A planner kept up to date while a wall is dropped on its path and lifted again
+*/
+typedef struct ReplanBench
+{
+    Map map;
+    Planner planner;
+    Node * path;
+    int capacity;
+} ReplanBench;
+
+/*
+    Block the middle of the current path, repair it, then open the cell again and repair again
+*/
+void Replan(void * context)
+{
+    ReplanBench * bench = (ReplanBench *)context;
+    int length = Planner_namespace.Path(&bench->planner, bench->path, bench->capacity, NULL);
+    if(length < 3)
+    {
+        return;
+    }
+    PlannerEdit edit = {bench->path[length / 2].x, bench->path[length / 2].y, WALL};
+    Planner_namespace.Edit(&bench->planner, &edit, 1);
+    Planner_namespace.Path(&bench->planner, NULL, 0, NULL);
+    edit.value = FREE;
+    Planner_namespace.Edit(&bench->planner, &edit, 1);
+    Planner_namespace.Path(&bench->planner, NULL, 0, NULL);
+}
+
+/*
+    Time two local repairs of an incremental planner, against a full solve of the same map
+    and report the cells the repairs expanded
+    prefix = prefix of the benchmark names
+*/
+void BenchReplan(const Map * map, const char * prefix)
+{
+    ReplanBench bench;
+    CopyMap(&bench.map, map, MAP_CELLS);
+    Node start = {map->start, 0};
+    Node end = {map->end, map->height - 1};
+    bench.capacity = map->width * map->height;
+    bench.path = (Node *)malloc((size_t)bench.capacity * sizeof(Node));
+    if(bench.path && Planner_namespace.Init(&bench.planner, &bench.map, start, end))
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "%s_replan_edit", prefix);
+        Benchmark benchmark = {name, NULL, Replan, &bench, 1};
+        Bench_namespace.Run(&benchmark);
+
+        // Work of one blocking edit on its own
+        SolverStats stats = {0};
+        int length = Planner_namespace.Path(&bench.planner, bench.path, bench.capacity, NULL);
+        PlannerEdit edit = {bench.path[length / 2].x, bench.path[length / 2].y, WALL};
+        Planner_namespace.Edit(&bench.planner, &edit, 1);
+        Planner_namespace.Path(&bench.planner, NULL, 0, &stats);
+        snprintf(name, sizeof(name), "%s_replan_edit_expanded", prefix);
+        Bench_namespace.Metric(name, "nodes", (double)stats.expanded);
+        Planner_namespace.Destroy(&bench.planner);
+    }
+    free(bench.path);
+    Map_namespace.Destroy(&bench.map);
+}
+
+/*
+    Random start/end pairs on one map, answered by the abstract graph or by flooding the map
+*/
+typedef struct HierarchyBench
+{
+    const Map * map;
+    HpaGraph graph;
+    Node starts[PAIR_COUNT];
+    Node ends[PAIR_COUNT];
+    Node * path;    // Room for a path through every cell
+} HierarchyBench;
+
+void BuildHierarchy(void * context)
+{
+    HierarchyBench * bench = (HierarchyBench *)context;
+    HpaGraph graph;
+    if(Hpa_namespace.Build(&graph, bench->map, HPA_CLUSTER_SIZE))
+    {
+        Hpa_namespace.Destroy(&graph);
+    }
+}
+
+void QueryHierarchy(void * context)
+{
+    HierarchyBench * bench = (HierarchyBench *)context;
+    for(int i = 0; i < PAIR_COUNT; i++)
+    {
+        Hpa_namespace.Query(&bench->graph, bench->map, bench->starts[i], bench->ends[i], bench->path,
+            bench->map->width * bench->map->height, NULL);
+    }
+}
+
+void QueryFlat(void * context)
+{
+    HierarchyBench * bench = (HierarchyBench *)context;
+    for(int i = 0; i < PAIR_COUNT; i++)
+    {
+        Solver_namespace.FindPath(bench->map, bench->starts[i], bench->ends[i], bench->path,
+            bench->map->width * bench->map->height, NULL, NULL);
+    }
+}
+
+/*
+    Time building the abstract graph, and PAIR_COUNT paths between random open cells found with it
+    against flooding the map for each. Reports how much longer the hierarchical paths are, in percent
+    prefix = prefix of the benchmark names
+*/
+void BenchHierarchy(const Map * map, const char * prefix)
+{
+    HierarchyBench bench;
+    bench.map = map;
+    SeedRandom(5);
+    for(int i = 0; i < PAIR_COUNT; i++)
+    {
+        Node * nodes[2] = {&bench.starts[i], &bench.ends[i]};
+        for(int ii = 0; ii < 2; ii++)
+        {
+            do
+            {
+                nodes[ii]->x = Random() % map->width;
+                nodes[ii]->y = Random() % map->height;
+            } while(MapGetUnchecked(map, nodes[ii]->x, nodes[ii]->y) == WALL);
+        }
+    }
+    bench.path = (Node *)malloc((size_t)map->width * map->height * sizeof(Node));
+    if(!bench.path || !Hpa_namespace.Build(&bench.graph, map, HPA_CLUSTER_SIZE))
+    {
+        free(bench.path);
+        return;
+    }
+
+    char names[3][64];
+    snprintf(names[0], sizeof(names[0]), "%s_hpa_build", prefix);
+    snprintf(names[1], sizeof(names[1]), "%s_hpa_query", prefix);
+    snprintf(names[2], sizeof(names[2]), "%s_flat_query", prefix);
+    const Benchmark benchmarks[] =
+    {
+        {names[0], NULL, BuildHierarchy, &bench, 1},
+        {names[1], NULL, QueryHierarchy, &bench, 1},
+        {names[2], NULL, QueryFlat,      &bench, 1},
+    };
+    for(size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++)
+    {
+        Bench_namespace.Run(&benchmarks[i]);
+    }
+
+    double hierarchical = 0;
+    double shortest = 0;
+    for(int i = 0; i < PAIR_COUNT; i++)
+    {
+        hierarchical += Hpa_namespace.Query(&bench.graph, map, bench.starts[i], bench.ends[i], NULL, 0, NULL);
+        shortest += Solver_namespace.FindPath(map, bench.starts[i], bench.ends[i], NULL, 0, NULL, NULL);
+    }
+    char name[64];
+    snprintf(name, sizeof(name), "%s_hpa_path_overhead", prefix);
+    Bench_namespace.Metric(name, "%", shortest > 0 ? (hierarchical / shortest - 1) * 100 : 0);
+    Hpa_namespace.Destroy(&bench.graph);
+    free(bench.path);
+}
+
+/*
+    A map whose dead ends are filled every sample, restored from the source map in between
+*/
+typedef struct FillBench
+{
+    const Map * source;
+    Map map;
+} FillBench;
+
+void RestoreFill(void * context)
+{
+    FillBench * bench = (FillBench *)context;
+    for(int y = 0; y < bench->map.height; y++)
+    {
+        for(int w = 0; w < bench->map.stride; w++)
+        {
+            Map_namespace.SetRowWord(&bench->map, y, w, Map_namespace.GetRowWord((Map *)bench->source, y, w));
+        }
+    }
+}
+
+void RunFill(void * context)
+{
+    Solver_namespace.FillDeadEnds(&((FillBench *)context)->map, NULL);
+}
+
+/*
+    Time filling the dead ends of the map, report the share of the open cells filled, then time
+    the flood fill on the filled map to compare with the unfilled one
+    prefix = prefix of the benchmark names
+*/
+void BenchDeadEnds(const Map * map, const char * prefix)
+{
+    FillBench bench;
+    bench.source = map;
+    CopyMap(&bench.map, map, MAP_PACKED);
+    char names[3][64];
+    snprintf(names[0], sizeof(names[0]), "%s_dead_end_fill", prefix);
+    snprintf(names[1], sizeof(names[1]), "%s_dead_end_filled", prefix);
+    snprintf(names[2], sizeof(names[2]), "%s_filled_solve", prefix);
+    Benchmark fill = {names[0], RestoreFill, RunFill, &bench, 1};
+    Bench_namespace.Run(&fill);
+
+    size_t open = 0;
+    for(int y = 0; y < map->height; y++)
+    {
+        for(int w = 0; w < bench.map.stride; w++)
+        {
+            int bits = __min(WORD_BITS, map->width - w * WORD_BITS);
+            open += bits - __builtin_popcountll(Map_namespace.GetRowWord((Map *)map, y, w));
+        }
+    }
+    RestoreFill(&bench);
+    SolverStats stats = {0};
+    if(open && Solver_namespace.FillDeadEnds(&bench.map, &stats))
+    {
+        Bench_namespace.Metric(names[1], "%", 100.0 * stats.expanded / open);
+        SolveBench solve;
+        solve.solver = Solver_namespace.Find("bfs");
+        CopyMap(&solve.map, &bench.map, solve.solver->format);
+        Benchmark filled = {names[2], ClearSolve, RunSolve, &solve, 1};
+        Bench_namespace.Run(&filled);
+        Map_namespace.Destroy(&solve.map);
+    }
+    Map_namespace.Destroy(&bench.map);
+}
+
+/*
+    A map with a cost plane, and the same map without one
+*/
+typedef struct WeightedBench
+{
+    Map weighted;
+    Map unit;
+    Node start;
+    Node end;
+} WeightedBench;
+
+void FindWeighted(void * context)
+{
+    WeightedBench * bench = (WeightedBench *)context;
+    Solver_namespace.FindPathWeighted(&bench->weighted, bench->start, bench->end, NULL, 0, NULL, NULL, NULL);
+}
+
+void FindUnitWeighted(void * context)
+{
+    WeightedBench * bench = (WeightedBench *)context;
+    Solver_namespace.FindPathWeighted(&bench->unit, bench->start, bench->end, NULL, 0, NULL, NULL, NULL);
+}
+
+/*
+    Time the bucket queue search from the start to the end point on the map with every cell
+    costing 1 to 8, and with unit costs to compare against the breadth first searches
+    prefix = prefix of the benchmark names
+*/
+void BenchWeighted(const Map * map, const char * prefix)
+{
+    WeightedBench bench;
+    CopyMap(&bench.weighted, map, MAP_CELLS);
+    CopyMap(&bench.unit, map, MAP_CELLS);
+    bench.start.x = map->start;
+    bench.start.y = 0;
+    bench.end.x = map->end;
+    bench.end.y = map->height - 1;
+    SeedRandom(9);
+    BOOL costs = TRUE;
+    for(int y = 0; y < map->height && costs; y++)
+    {
+        for(int x = 0; x < map->width && costs; x++)
+        {
+            costs = Map_namespace.SetCost(&bench.weighted, x, y, 1 + Random() % 8);
+        }
+    }
+    if(costs)
+    {
+        char names[2][64];
+        snprintf(names[0], sizeof(names[0]), "%s_weighted_path", prefix);
+        snprintf(names[1], sizeof(names[1]), "%s_weighted_unit_path", prefix);
+        Benchmark weighted = {names[0], NULL, FindWeighted, &bench, 1};
+        Benchmark unit = {names[1], NULL, FindUnitWeighted, &bench, 1};
+        Bench_namespace.Run(&weighted);
+        Bench_namespace.Run(&unit);
+    }
+    Map_namespace.Destroy(&bench.weighted);
+    Map_namespace.Destroy(&bench.unit);
+}
+
+/*
+    A map whose end point is walled in, so only a full search learns it cannot be reached
+*/
+typedef struct ReachBench
+{
+    Map map;
+    LabelPlane plane;
+    Node starts[PAIR_COUNT];
+    Node end;
+} ReachBench;
+
+void FloodUnreachable(void * context)
+{
+    ReachBench * bench = (ReachBench *)context;
+    Solver_namespace.FindPath(&bench->map, bench->starts[0], bench->end, NULL, 0, NULL, NULL);
+}
+
+void BuildLabels(void * context)
+{
+    ReachBench * bench = (ReachBench *)context;
+    LabelPlane plane;
+    if(Labels_namespace.Build(&plane, &bench->map))
+    {
+        Labels_namespace.Destroy(&plane);
+    }
+}
+
+void QueryLabels(void * context)
+{
+    ReachBench * bench = (ReachBench *)context;
+    volatile int connected = 0;
+    for(int i = 0; i < PAIR_COUNT; i++)
+    {
+        connected += Labels_namespace.Connected(&bench->plane, bench->starts[i], bench->end);
+    }
+}
+
+/*
+    Time learning that the walled in end point cannot be reached: by a search that floods the start's
+    component, by labelling the components once, and by PAIR_COUNT lookups in the labels
+    prefix = prefix of the benchmark names
+*/
+void BenchReachability(const Map * map, const char * prefix)
+{
+    ReachBench bench;
+    CopyMap(&bench.map, map, MAP_CELLS);
+    bench.end.x = map->end;
+    bench.end.y = map->height - 1;
+    Map_namespace.SetCell(&bench.map, bench.end.x, bench.end.y - 1, WALL);
+    Map_namespace.SetCell(&bench.map, bench.end.x - 1, bench.end.y, WALL);
+    Map_namespace.SetCell(&bench.map, bench.end.x + 1, bench.end.y, WALL);
+    if(!Labels_namespace.Build(&bench.plane, &bench.map))
+    {
+        Map_namespace.Destroy(&bench.map);
+        return;
+    }
+    // Starts in the largest component, so the search has the most to flood
+    uint32_t largest = 1;
+    for(uint32_t i = 2; i <= bench.plane.count; i++)
+    {
+        largest = (bench.plane.sizes[i] > bench.plane.sizes[largest]) ? i : largest;
+    }
+    SeedRandom(7);
+    for(int i = 0; i < PAIR_COUNT; i++)
+    {
+        Labels_namespace.RandomCell(&bench.plane, largest, &bench.starts[i]);
+    }
+
+    char names[3][64];
+    snprintf(names[0], sizeof(names[0]), "%s_unreachable_search", prefix);
+    snprintf(names[1], sizeof(names[1]), "%s_label_build", prefix);
+    snprintf(names[2], sizeof(names[2]), "%s_label_query", prefix);
+    const Benchmark benchmarks[] =
+    {
+        {names[0], NULL, FloodUnreachable, &bench, 1},
+        {names[1], NULL, BuildLabels,      &bench, 1},
+        {names[2], NULL, QueryLabels,      &bench, 1},
+    };
+    for(size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++)
+    {
+        Bench_namespace.Run(&benchmarks[i]);
+    }
+    Labels_namespace.Destroy(&bench.plane);
+    Map_namespace.Destroy(&bench.map);
+}
+
+/*
+    Path queries from random cells to the end point of one map, as a game asks them
+*/
+typedef struct QueryBench
+{
+    const Map * map;
+    Node starts[PAIR_COUNT];
+    Node end;
+    Node * path;    // Room for a path through every cell
+    DistanceCache cache;
+} QueryBench;
+
+void QueryUncached(void * context)
+{
+    QueryBench * bench = (QueryBench *)context;
+    for(int i = 0; i < PAIR_COUNT; i++)
+    {
+        Solver_namespace.FindPath(bench->map, bench->starts[i], bench->end, NULL, 0, NULL, NULL);
+    }
+}
+
+void QueryCached(void * context)
+{
+    QueryBench * bench = (QueryBench *)context;
+    for(int i = 0; i < PAIR_COUNT; i++)
+    {
+        Cache_namespace.Query(&bench->cache, bench->map, bench->starts[i], bench->end, bench->path,
+            bench->map->width * bench->map->height);
+    }
+}
+
+/*
+    Time PAIR_COUNT queries towards the end point, flooding the map for every query
+    against walking a cached distance field. The cache is built during the warm-up
+*/
+void BenchQueries(const Map * map)
+{
+    QueryBench bench;
+    bench.map = map;
+    bench.end.x = map->end;
+    bench.end.y = map->height - 1;
+    SeedRandom(3);
+    for(int i = 0; i < PAIR_COUNT; i++)
+    {
+        bench.starts[i].x = (Random() % (map->width / 2)) * 2 + 1;
+        bench.starts[i].y = (Random() % (map->height / 2)) * 2 + 1;
+    }
+    bench.path = (Node *)malloc((size_t)map->width * map->height * sizeof(Node));
+    if(!bench.path || !Cache_namespace.Init(&bench.cache, 4))
+    {
+        free(bench.path);
+        return;
+    }
+    Benchmark uncached = {"query_uncached", NULL, QueryUncached, &bench, 1};
+    Benchmark cached = {"query_cached", NULL, QueryCached, &bench, 1};
+    Bench_namespace.Run(&uncached);
+    Bench_namespace.Run(&cached);
+    Cache_namespace.Destroy(&bench.cache);
+    free(bench.path);
+}
+
+/*
+    Benchmark loading, saving and solving a generated maze, and solving an open room
+    map_bench [benchmark options] [size]
+*/
+int main(int argc, char * argv[])
+{
+    int first = Bench_namespace.Init(argc, argv, "map");
+    if(first < 0)
+    {
+        return 1;
+    }
+    int size = (first < argc) ? atoi(argv[first]) | 1 : DEFAULT_SIZE;
+
+    MapBench bench;
+    GenerateMaze(&bench.map, size);
+
+    // Write the files up front, so the loads have something to read even if the saves are filtered out
+    if(!Map_namespace.SaveMap(&bench.map, TEXT_FILE) || !Map_namespace.SaveMapBinary(&bench.map, BINARY_FILE))
+    {
+        Map_namespace.Destroy(&bench.map);
+        return 1;
+    }
+
+    const Benchmark benchmarks[] =
+    {
+        {"save_text",    NULL,   SaveText,   &bench, 1},
+        {"load_text",    NULL,   LoadText,   &bench, 1},
+        {"save_binary",  NULL,   SaveBinary, &bench, 1},
+        {"load_binary",  NULL,   LoadBinary, &bench, 1},
+    };
+    for(size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++)
+    {
+        Bench_namespace.Run(&benchmarks[i]);
+    }
+    BenchSolvers(&bench.map, "solve");
+    BenchPairs(&bench.map);
+    BenchQueries(&bench.map);
+    BenchDeadEnds(&bench.map, "maze");
+
+    Map room;
+    GenerateRoom(&room, size);
+    BenchSolvers(&room, "room_solve");
+    BenchParallel(&room, "room_solve");
+    BenchReplan(&room, "room");
+    BenchHierarchy(&room, "room");
+    BenchReachability(&room, "room");
+    BenchWeighted(&room, "room");
+
+    Map_namespace.Destroy(&bench.map);
+    Map_namespace.Destroy(&room);
+    remove(TEXT_FILE);
+    remove(BINARY_FILE);
+    return Bench_namespace.Finish();
+}
@@ -0,0 +1,81 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "./common/common.h"
+#include "./common/hpa.h"
+#include "./common/external.h"
+
+/*
+    Return TRUE if the filename ends with the given extension
+*/
+BOOL HasExtension(char * filename, char * extension)
+{
+    size_t length = strlen(filename);
+    size_t extLength = strlen(extension);
+    return length >= extLength && strcmp(filename + length - extLength, extension) == 0;
+}
+
+/*
+    Convert maps between the hex text format and the binary format
+    The input format is detected from the file, the output format from the extension (.bin is binary)
+    Text maps do not store start/end points, so they are generated when converting from text
+    A .hpa output is the abstract graph for hierarchical path finding on the map, to keep next to it
+    A .path output solves a packed binary map without loading it, a band of rows at a time, for maps
+    larger than memory. The path is written as "x y" lines from the end point back to the start
+*/
+int main(int argc, char * argv[])
+{
+    if(argc < 3)
+    {
+        printf("map_convert:\n");
+        printf("map_convert <input> <output.bin> [packed] to convert to binary\n");
+        printf("map_convert <input> <output.txt> to convert to text\n");
+        printf("map_convert <input> <output.hpa> [cluster size] to build the path finding graph\n");
+        printf("map_convert <input.bin> <output.path> [memory MB] [scratch file] to solve a packed map out of core\n");
+        return 1;
+    }
+
+    // Out of core, the map is never loaded
+    if(HasExtension(argv[2], ".path"))
+    {
+        size_t memory = (argc > 3) ? (size_t)atol(argv[3]) << 20 : EXTERNAL_MEMORY;
+        ExternalStats stats = {0};
+        BOOL solved = External_namespace.Solve(argv[1], argv[2], memory, argc > 4 ? argv[4] : NULL, &stats);
+        printf("path %zu, %zu expanded, %d sweeps, %zu band loads of %d rows, %zu bytes in memory\n",
+            stats.length, stats.expanded, stats.sweeps, stats.bandLoads, stats.bandRows, stats.memory);
+        return solved ? 0 : 3;
+    }
+
+    // Seed the random generator, used for start/end points of text maps
+    time_t t;
+    SeedRandom((unsigned) time(&t));
+
+    int format = (argc > 3 && strcmp(argv[3], "packed") == 0) ? MAP_PACKED : MAP_CELLS;
+
+    Map map;
+    if(!Map_namespace.LoadMapFormat(&map, argv[1], format))
+    {
+        return 2;
+    }
+
+    BOOL success = FALSE;
+    if(HasExtension(argv[2], ".hpa"))
+    {
+        HpaGraph graph;
+        if(Hpa_namespace.Build(&graph, &map, argc > 3 ? atoi(argv[3]) : HPA_CLUSTER_SIZE))
+        {
+            success = Hpa_namespace.Save(&graph, argv[2]);
+            Hpa_namespace.Destroy(&graph);
+        }
+    }
+    else
+    {
+        success = HasExtension(argv[2], ".bin")
+            ? Map_namespace.SaveMapBinary(&map, argv[2])
+            : Map_namespace.SaveMap(&map, argv[2]);
+    }
+
+    Map_namespace.Destroy(&map);
+    return success ? 0 : 3;
+}
@@ -5,6 +5,9 @@
 #include <time.h>
 #include <math.h>
 #include "./common/common.h"
+#include "./common/arena.h"
+#include "./common/pacer.h"
+#include "./common/grid.h"
 
 #include <SDL2/SDL.h>
 
@@ -12,35 +15,23 @@
 #define WINDOW_HEIGHT   800
 #define FPS_COUNT       60
 
-enum Directions
-{
-    cNorth = 1,
-    cSouth = 2,
-    cEast  = 4,
-    cWest  = 8
-};
-
-int ShuffleArray(int * array, int size)
+void ShuffleArray(int * array, int size)
 {
     for(int i = 0; i < size - 1; i++)
     {
-        int r = i + (rand() % (size - i));
-        array[i] += array[r];
-        array[r] = array[i] - array[r];
-        array[i] -= array[r];
+        int r = i + (Random() % (size - i));
+        int temp = array[i];
+        array[i] = array[r];
+        array[r] = temp;
     }
 }
 
 /*
     Drawing, input and rendering function
-    Moved to a function so that it can be called from within multiple parts of the maze solving algorithm
+    Draws the cells marked since the last frame, the frame rate is kept by the Pacer that calls it
 */
-BOOL DrawCells(Map * map, SDL_Renderer * pRenderer)
+BOOL DrawCells(Map * map, GridRenderer * grid)
 {
-    // Clear screen and set renderer colour to white
-    SDL_SetRenderDrawColor(pRenderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
-    SDL_RenderClear(pRenderer);
-
     // Check events to resolve exit and to keep app responsive
     SDL_Event e;
     while(SDL_PollEvent(&e) != 0)
@@ -50,155 +41,229 @@ BOOL DrawCells(Map * map, SDL_Renderer * pRenderer)
             return FALSE;
         }
     }
-    
-    // Draw the map cells
-    int rectSize = __min(WINDOW_WIDTH / map->width, WINDOW_HEIGHT / map->height);
-    for(int i = 0, x = 0; i < map->width; i++, x += rectSize)
-    {
-        for(int ii = 0, y = 0; ii < map->height; ii++, y += rectSize)
-        {
-            switch(Map_namespace.GetCell(map, i, ii))
-            {
-            case WALL:
-                SDL_SetRenderDrawColor(pRenderer, 54, 34, 199, SDL_ALPHA_OPAQUE);
-                break;
-            case PATH:
-                SDL_SetRenderDrawColor(pRenderer, 54, 199, 34, SDL_ALPHA_OPAQUE);
-                break;
-            case FREE:
-                SDL_SetRenderDrawColor(pRenderer, 255, 255, 255, SDL_ALPHA_OPAQUE);
-                break;
-            default: // Route candidate
-                SDL_SetRenderDrawColor(pRenderer, 255, 165, 0, SDL_ALPHA_OPAQUE);
-                break;
-            }
-            SDL_Rect rect;
-            rect.w = rectSize - 1;
-            rect.h = rectSize - 1;
-            rect.x = x;
-            rect.y = y;
-            SDL_RenderFillRect(pRenderer, &rect);
-        }
-    }
-    // Update screen and delay
-    SDL_RenderPresent(pRenderer);
-    SDL_Delay((1.0 / FPS_COUNT) * 1000);
+    Grid_namespace.Draw(grid, map);
     return TRUE;
 }
 
+/*
+    Map and grid renderer of the window, drawn by the pacer
+*/
+typedef struct View
+{
+    Map * map;
+    GridRenderer grid;
+} View;
+
+BOOL DrawView(void * context)
+{
+    View * view = (View *)context;
+    return DrawCells(view->map, &view->grid);
+}
+
+/*
+    State of one cell on the backtracking stack: the shuffled directions and the next one to try
+*/
+typedef struct CarveFrame
+{
+    int x;
+    int y;
+    int directions[4];
+    int next;
+} CarveFrame;
+
+/*
+    Push a new cell onto the backtracking stack, with its directions shuffled
+*/
+void PushFrame(CarveFrame * stack, int * depth, int x, int y)
+{
+    CarveFrame * frame = &stack[(*depth)++];
+    frame->x = x;
+    frame->y = y;
+    frame->directions[0] = cNorth;
+    frame->directions[1] = cEast;
+    frame->directions[2] = cSouth;
+    frame->directions[3] = cWest;
+    frame->next = 0;
+    ShuffleArray(frame->directions, 4);
+}
+
 /*
     Recursive backtracking algorithm
     Carve a path at random and recursively make branches
+    The recursion is kept on an explicit stack, allocated from the map's arena if it has one,
+    so large mazes do not overflow the call stack
+    pacer = reported every carved cell so it can draw the progress, NULL to carve without drawing
+    grid  = marked with every carved cell, so frames only redraw those. NULL without a pacer
+    Return FALSE if the window was closed or memory ran out
 */
-BOOL CarvePassageFrom(Map * map, SDL_Renderer * pRenderer, int x, int y, int depth)
+BOOL CarvePassageFrom(Map * map, Pacer * pacer, GridRenderer * grid, int x, int y)
 {
-    // 4 directions that we can go in, shuffled
-    int directions[4] = {cNorth, cEast, cSouth, cWest};
-    ShuffleArray(directions, 4);
-    for(int i = 0; i < 4; i++)
+    // Every cell is pushed at most once, and only cells two steps apart are pushed
+    size_t capacity = (size_t)(map->width / 2 + 1) * (map->height / 2 + 1);
+    ArenaMark mark = map->arena ? Arena_namespace.Mark(map->arena) : 0;
+    CarveFrame * stack = map->arena ? (CarveFrame *)Arena_namespace.Alloc(map->arena, capacity * sizeof(CarveFrame)) : NULL;
+    BOOL scratch = (stack != NULL);
+    stack = scratch ? stack : (CarveFrame *)malloc(capacity * sizeof(CarveFrame));
+    if(!stack)
     {
-        if(directions[i] == cNorth)
+        return FALSE;
+    }
+
+    BOOL running = TRUE;
+    int depth = 0;
+    PushFrame(stack, &depth, x, y);
+    while(running && depth > 0)
+    {
+        CarveFrame * frame = &stack[depth - 1];
+        if(frame->next == 4) // All directions tried, backtrack
         {
-            if((y > 2) && Map_namespace.GetCell(map, x, y - 2) == WALL)
-            {
-                for(int ii = 0; ii < 3; ii++)
-                {
-                    Map_namespace.SetCell(map, x, y - 2 + ii, FREE);
-                    if(!DrawCells(map, pRenderer))
-                    {
-                        return FALSE;
-                    }
-                }
-                if(!CarvePassageFrom(map, pRenderer, x, y - 2, depth + 1))
-                {
-                    return FALSE;
-                }
-            }
+            depth--;
+            continue;
         }
-        else if(directions[i] == cSouth)
+        int direction = frame->directions[frame->next++];
+        x = frame->x;
+        y = frame->y;
+
+        // Target cell two steps away, and the first of the three cells to carve towards it
+        int tx = x;
+        int ty = y;
+        int cx = x;
+        int cy = y;
+        BOOL valid = FALSE;
+        if(direction == cNorth)
         {
-            if(((y + 2) < map->height - 1) && Map_namespace.GetCell(map, x, y + 2) == WALL)
-            {
-                for(int ii = 0; ii < 3; ii++)
-                {
-                    Map_namespace.SetCell(map, x, y + ii, FREE);
-                    if(!DrawCells(map, pRenderer))
-                    {
-                        return FALSE;
-                    }
-                }
-                if(!CarvePassageFrom(map, pRenderer, x, y + 2, depth + 1))
-                {
-                    return FALSE;
-                }
-            }
+            ty = y - 2;
+            cy = y - 2;
+            valid = (y > 2);
         }
-        else if(directions[i] == cEast)
+        else if(direction == cSouth)
         {
-            if(((x + 2) < map->width - 1) && Map_namespace.GetCell(map, x + 2, y) == WALL)
-            {
-                for(int ii = 0; ii < 3; ii++)
-                {
-                    Map_namespace.SetCell(map, x + ii, y, FREE);
-                    if(!DrawCells(map, pRenderer))
-                    {
-                        return FALSE;
-                    }
-                }
-                if(!CarvePassageFrom(map, pRenderer, x + 2, y, depth + 1))
-                {
-                    return FALSE;
-                }
-            }
+            ty = y + 2;
+            valid = ((y + 2) < map->height - 1);
         }
-        else if(directions[i] == cWest)
+        else if(direction == cEast)
         {
-            if((x > 2) && Map_namespace.GetCell(map, x - 2, y) == WALL)
+            tx = x + 2;
+            valid = ((x + 2) < map->width - 1);
+        }
+        else if(direction == cWest)
+        {
+            tx = x - 2;
+            cx = x - 2;
+            valid = (x > 2);
+        }
+        if(!valid || MapGetUnchecked(map, tx, ty) != WALL)
+        {
+            continue;
+        }
+
+        for(int ii = 0; ii < 3 && running; ii++)
+        {
+            BOOL vertical = (direction == cNorth || direction == cSouth);
+            int carveX = vertical ? cx : cx + ii;
+            int carveY = vertical ? cy + ii : cy;
+            Map_namespace.SetCell(map, carveX, carveY, FREE);
+            if(pacer)
             {
-                for(int ii = 0; ii < 3; ii++)
-                {
-                    Map_namespace.SetCell(map, x - 2 + ii, y, FREE);
-                    if(!DrawCells(map, pRenderer))
-                    {
-                        return FALSE;
-                    }
-                }
-                if(!CarvePassageFrom(map, pRenderer, x - 2, y, depth + 1))
-                {
-                    return FALSE;
-                }
+                Grid_namespace.Mark(grid, carveX, carveY);
+                running = Pacer_namespace.Step(pacer);
             }
         }
+        PushFrame(stack, &depth, tx, ty);
     }
 
-    if(depth == 1)
+    if(scratch)
     {
-        // Generate an endpoint
-        {
-            int min     = 1;
-            int max     = map->width - 2;
-            map->end     = (unsigned int)(rand() % (max + 1 - min) + min);    
-            Map_namespace.SetCell(map, map->end, map->width - 1, 0);
-        }
-        BOOL running = Map_namespace.SaveMap(map, "newmap.txt");
-        while(running)
+        Arena_namespace.Reset(map->arena, mark);
+    }
+    else
+    {
+        free(stack);
+    }
+    if(!running)
+    {
+        return FALSE;
+    }
+
+    // Generate an endpoint
+    {
+        int min     = 1;
+        int max     = map->width - 2;
+        map->end     = (unsigned int)(Random() % (max + 1 - min) + min);
+        Map_namespace.SetCell(map, map->end, map->height - 1, 0);
+        if(grid)
         {
-            running = DrawCells(map, pRenderer);
+            Grid_namespace.Mark(grid, map->end, map->height - 1);
         }
-        if(!running)
+    }
+    return TRUE;
+}
+
+#ifdef BENCHMARK
+#include "./common/bench.h"
+
+#define BENCH_SIZE 255
+
+/*
+    Fill the map with walls again and open the entrance, seeded so every sample carves the same maze
+*/
+void ResetMaze(void * context)
+{
+    Map * map = (Map *)context;
+    for(int x = 0; x < map->width; x++)
+    {
+        for(int y = 0; y < map->height; y++)
         {
-            return FALSE;
+            MapSetUnchecked(map, x, y, WALL);
         }
     }
-    return TRUE;
+    SeedRandom(1);
+    map->start = (map->width / 2) | 1;
+    Map_namespace.SetCell(map, map->start, 0, FREE);
+}
+
+void Carve(void * context)
+{
+    Map * map = (Map *)context;
+    CarvePassageFrom(map, NULL, NULL, map->start, 1);
 }
 
+/*
+    Benchmark carving a maze without drawing it
+    maze_generator [benchmark options] [size]
+*/
+int main(int argc, char * argv[])
+{
+    int first = Bench_namespace.Init(argc, argv, "maze_generator");
+    if(first < 0)
+    {
+        return 1;
+    }
+    int size = (first < argc) ? atoi(argv[first]) | 1 : BENCH_SIZE;
+
+    Map map;
+    Map_namespace.InitFormat(&map, size, size, WALL, MAP_PACKED);
+    Benchmark carve = {"carve", ResetMaze, Carve, &map, 1};
+    Bench_namespace.Run(&carve);
+    Map_namespace.Destroy(&map);
+    return Bench_namespace.Finish();
+}
+#else
 /*
     Generating a maze using recursive backtracking method.
     It's not perfect and sometimes the maze has a lot of blank spaces but it's good enough
+    maze_generator [-p steps per frame] [-t ms of work per frame] [size]
 */
 int main(int argc, char * argv[])
 {
+    Map map;
+    View view;
+    view.map = &map;
+    Pacer pacer;
+    int first = Pacer_namespace.Init(&pacer, argc, argv, FPS_COUNT, DrawView, &view);
+    int size = (first < argc) ? atoi(argv[first]) : 32;
+    size = __max(size, 5);
+
     SDL_Window   * pWindow   = NULL;
     SDL_Surface  * pSurface  = NULL;
     SDL_Renderer * pRenderer = NULL;
@@ -214,21 +279,37 @@ int main(int argc, char * argv[])
         return -2;
     }
 
-    Map map;
-    Map_namespace.Init(&map, 32, 32, WALL);
+    // One arena for the map and the carving stack
+    Arena arena;
+    if(!Arena_namespace.Init(&arena, 64 * 1024 + (size_t)size * size))
+    {
+        return -3;
+    }
+
+    Map_namespace.InitArena(&map, size, size, WALL, MAP_PACKED, &arena); // Generator only carves FREE/WALL, 1 bit per cell is enough
+    if(!Grid_namespace.Init(&view.grid, pRenderer, map.width, map.height))
+    {
+        return -4;
+    }
     
     // generate start end manually, since all cells are of WALL value
     // Keep it in separate scope
     {
         int min     = 1;
         int max     = map.width - 2;
-        map.start   = (unsigned int)(rand() % (max + 1 - min) + min);
+        map.start   = (unsigned int)(Random() % (max + 1 - min) + min);
         Map_namespace.SetCell(&map, map.start, 0, 0);
     }
-    CarvePassageFrom(&map, pRenderer, map.start, 1, 1); // Main loop inside
+    BOOL running = CarvePassageFrom(&map, &pacer, &view.grid, map.start, 1) && Map_namespace.SaveMap(&map, "newmap.txt");
+    while(running)
+    {
+        running = Pacer_namespace.Present(&pacer);
+    }
 
     // Cleanup
+    Grid_namespace.Destroy(&view.grid);
     Map_namespace.Destroy(&map);
+    Arena_namespace.Destroy(&arena);
 
     // SDL2 Cleanup
     if(pSurface)
@@ -246,3 +327,4 @@ int main(int argc, char * argv[])
     SDL_Quit();
     return 0;
 }
+#endif // BENCHMARK
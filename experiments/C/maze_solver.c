@@ -1,38 +1,39 @@
 #define _GNU_SOURCE
 
 #include "./common/common.h"
+#include "./common/queue.h"
+#include "./common/solver.h"
+#include "./common/arena.h"
+#include "./common/pool.h"
+#include "./common/labels.h"
+#include "./common/pacer.h"
+#include "./common/grid.h"
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
 #include <SDL2/SDL.h>
 
 #define WINDOW_WIDTH    800
 #define WINDOW_HEIGHT   800
 #define FPS_COUNT       25
 
-/*
-    Struct representing a node on a map
-    x = x coordinate
-    y = y coordinate
-*/
-typedef struct Node
-{
-    unsigned int x;
-    unsigned int y;
-} Node;
+#define BATCH_ARENA_SIZE    (32 << 20) // Scratch memory per batch thread, in bytes
 
 /*
     Drawing, input and rendering function
-    Moved to a function so that it can be called from within multiple parts of the maze solving algorithm
+    Draws the cells marked since the last frame, the frame rate is kept by the Pacer that calls it
 */
-BOOL DrawCells(Map * map, SDL_Renderer * pRenderer)
+BOOL DrawCells(Map * map, GridRenderer * grid)
 {
-    // Clear screen and set renderer colour to white
-    SDL_SetRenderDrawColor(pRenderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
-    SDL_RenderClear(pRenderer);
-
     // Check events to resolve exit and to keep app responsive
     SDL_Event e;
     while(SDL_PollEvent(&e) != 0)
@@ -42,162 +43,111 @@ BOOL DrawCells(Map * map, SDL_Renderer * pRenderer)
             return FALSE;
         }
     }
-    
-    // Draw the map cells
-    int rectSize = __min(WINDOW_WIDTH / map->width, WINDOW_HEIGHT / map->height);
-    for(int i = 0, x = 0; i < map->width; i++, x += rectSize)
-    {
-        for(int ii = 0, y = 0; ii < map->height; ii++, y += rectSize)
-        {
-            switch(Map_namespace.GetCell(map, i, ii))
-            {
-            case WALL:
-                SDL_SetRenderDrawColor(pRenderer, 54, 34, 199, SDL_ALPHA_OPAQUE);
-                break;
-            case PATH:
-                SDL_SetRenderDrawColor(pRenderer, 54, 199, 34, SDL_ALPHA_OPAQUE);
-                break;
-            case FREE:
-                SDL_SetRenderDrawColor(pRenderer, 255, 255, 255, SDL_ALPHA_OPAQUE);
-                break;
-            default: // Route candidate
-                SDL_SetRenderDrawColor(pRenderer, 255, 165, 0, SDL_ALPHA_OPAQUE);
-                break;
-            }
-            SDL_Rect rect;
-            rect.w = rectSize - 1;
-            rect.h = rectSize - 1;
-            rect.x = x;
-            rect.y = y;
-            SDL_RenderFillRect(pRenderer, &rect);
-        }
-    }
-    // Update screen and delay
-    SDL_RenderPresent(pRenderer);
-    SDL_Delay((1.0 / FPS_COUNT) * 1000);
+    Grid_namespace.Draw(grid, map);
     return TRUE;
 }
 
+/*
+    Map and grid renderer of the window, drawn by the pacer
+*/
+typedef struct View
+{
+    Map * map;
+    GridRenderer grid;
+} View;
+
+BOOL DrawView(void * context)
+{
+    View * view = (View *)context;
+    return DrawCells(view->map, &view->grid);
+}
+
 /*
     Visual implementation of the Solve function below
-    Encapsulates all solving and rendering logic
+    Every expanded node and every step back along the path is reported to the pacer,
+    which draws the map whenever a frame's worth of them is done
+    grid = marked with every cell the search changes, so frames only redraw those
 */
-void SolveRealtime(Map * map, SDL_Renderer * pRenderer)
+void SolveRealtime(Map * map, Pacer * pacer, GridRenderer * grid)
 {
     // Setup
-    int size = 1;  // size of our queue
-    int index = 0; // Index of the start of the queue 
-    int distanceCount = 3; // Distance walked (start at 3 to avoid confusion between 0 (free space) and 1 (wall))
+    int distanceCount = 4; // Distance walked (start past 3 to avoid confusion between 0 (free space), 1 (wall) and 2 (path))
     int x = 0;
     int y = 0;
     BOOL newDistance = TRUE;
     BOOL running = TRUE;
-    Node * distances = (Node *)malloc(sizeof(Node)); // Create a new array of size 1 and add the starting point
-    distances[0].x = map->start;
-    distances[0].y = 0;
+    // Scratch memory comes from the map's arena, if it has one
+    ArenaMark mark = map->arena ? Arena_namespace.Mark(map->arena) : 0;
+    Queue queue;
+    running = Queue_namespace.InitArena(&queue, sizeof(Node), map->width + map->height, map->arena);
+    Node node = {map->start, 0};
+    MapSetUnchecked(map, node.x, node.y, distanceCount);
+    Grid_namespace.Mark(grid, node.x, node.y);
+    Queue_namespace.Push(&queue, &node);
 
     // Walk away from the start location, remembering the distance to it
     while(newDistance && running)
     {
         newDistance = FALSE;
         distanceCount++;
-        int distanceMax = size - index; // Offset by the starting index (see below for more info)
-        for(int i = 0; i < distanceMax && running; i++)
+        size_t distanceMax = Queue_namespace.Size(&queue); // Nodes of the current distance
+        for(size_t i = 0; i < distanceMax && running; i++)
         {
-            x = distances[index].x;
-            y = distances[index].y;
-            Map_namespace.SetCell(map, x, y, distanceCount);
-            // North
-            if((y > 0) && Map_namespace.GetCell(map, x, y - 1) == FREE)
-            {
-                if(!ResizeArray((void **)&distances, ++size, sizeof(Node)))
-                {
-                    running = FALSE;
-                    break;
-                }
-                distances[size - 1].x = x;
-                distances[size - 1].y = y - 1;
-                newDistance = TRUE;
-            }
-             // South
-            if(((y + 1) < map->height) && Map_namespace.GetCell(map, x, y + 1) == FREE)
-            {
-                if(!ResizeArray((void **)&distances, ++size, sizeof(Node)))
-                {
-                    running = FALSE;
-                    break;
-                }
-                distances[size - 1].x = x;
-                distances[size - 1].y = y + 1;
-                newDistance = TRUE;
-            }
-            // East
-            if(((x + 1) < map->width) && Map_namespace.GetCell(map, x + 1, y) == FREE)
-            {
-                if(!ResizeArray((void **)&distances, ++size, sizeof(Node)))
-                {
-                    running = FALSE;
-                    break;
-                }
-                distances[size - 1].x = x + 1;
-                distances[size - 1].y = y;
-                newDistance = TRUE;
-            }
-            // West
-            if((x > 0) && Map_namespace.GetCell(map, x - 1, y) == FREE)
-            {
-                if(!ResizeArray((void **)&distances, ++size, sizeof(Node)))
-                {
-                    running = FALSE;
-                    break;
-                }
-                distances[size - 1].x = x - 1;
-                distances[size - 1].y = y;
-                newDistance = TRUE;
-            }
+            Queue_namespace.Pop(&queue, &node);
             // Destination. Break out of the loop
-            if(y == map->height - 1 && x == map->end)
+            if(node.y == map->height - 1 && node.x == map->end)
             {
                 newDistance = FALSE;
                 break;
             }
-            // Best approach would be to have a linked list and simply pop the first element from the queue
-            // I am too lazy and using a growing array instead
-            distances[index].x = -1;
-            distances[index++].y = -1;
-            running = DrawCells(map, pRenderer);
+            running = Solver_namespace.ExpandNode(map, &queue, node, distanceCount, &newDistance);
+            // The neighbours are the cells ExpandNode may have marked
+            Grid_namespace.Mark(grid, node.x, node.y - 1);
+            Grid_namespace.Mark(grid, node.x, node.y + 1);
+            Grid_namespace.Mark(grid, node.x + 1, node.y);
+            Grid_namespace.Mark(grid, node.x - 1, node.y);
+            running = running && Pacer_namespace.Step(pacer);
         }
     }
+    Queue_namespace.Destroy(&queue);
+    if(map->arena)
+    {
+        Arena_namespace.Reset(map->arena, mark);
+    }
 
     // Walk back towards the exit, marking nodes as solution on the way
     x = map->end;
     y = map->height - 1;
     distanceCount = Map_namespace.GetCell(map, x, y);
-    while(running && distanceCount != 3)
+    // The flood never reached the end point, there is nothing to walk back along
+    BOOL reached = distanceCount > 3;
+    while(running && reached && distanceCount != 3)
     {
-        Map_namespace.SetCell(map, x, y, PATH);
+        MapSetUnchecked(map, x, y, PATH);
+        Grid_namespace.Mark(grid, x, y);
         distanceCount--;
+        int closer = MapNeighbourMask(map, x, y, distanceCount);
         // North
-        if((y > 0) && (distanceCount == Map_namespace.GetCell(map, x, y - 1)))
+        if(closer & cNorth)
         {
             y--;
         }
         // South
-        else if(((y + 1) < map->height) && (distanceCount == Map_namespace.GetCell(map, x, y + 1)))
+        else if(closer & cSouth)
         {
             y++;
         }
         // East
-        else if(((x + 1) < map->width) && (distanceCount == Map_namespace.GetCell(map, x + 1, y)))
+        else if(closer & cEast)
         {
             x++;
         }
         // West
-        else if((x > 0) && (distanceCount == Map_namespace.GetCell(map, x - 1, y)))
+        else if(closer & cWest)
         {
             x--;
         }
-        running = DrawCells(map, pRenderer);
+        running = Pacer_namespace.Step(pacer);
     }    
 
     // Cleanup.
@@ -206,152 +156,463 @@ void SolveRealtime(Map * map, SDL_Renderer * pRenderer)
     {
         for(int ii = 0; ii < map->height; ii++)
         {
-            if(Map_namespace.GetCell(map, i, ii) != WALL && Map_namespace.GetCell(map, i, ii) != PATH)
+            unsigned int value = MapGetUnchecked(map, i, ii);
+            if(value != WALL && value != PATH)
             {
-                Map_namespace.SetCell(map, i, ii, FREE);
+                MapSetUnchecked(map, i, ii, FREE);
             }
         }
     }
+    Grid_namespace.MarkAll(grid);
 
     while(running)
     {
-        running = DrawCells(map, pRenderer);
+        running = Pacer_namespace.Present(pacer);
     }
 }
 
 /*
-    Solve the map using Dijkstra
+    List of map files to solve in batch mode
 */
-BOOL Solve(Map * map)
+typedef struct MapList
 {
-    int size = 1;  // size of our queue
-    int index = 0; // Index of the start of the queue 
-    int distanceCount = 3; // Distance walked (start at 3 to avoid confusion between 0 (free space) and 1 (wall))
-    int x = 0;
-    int y = 0;
-    BOOL newDistance = TRUE;
-    Node * distances = (Node *)malloc(sizeof(Node)); // Create a new array of size 1 and add the starting point
-    distances[0].x = map->start;
-    distances[0].y = 0;
+    char ** names;
+    int count;
+    int capacity;
+} MapList;
 
-    // Walk away from the start location, remembering the distance to it
-    while(newDistance)
+/*
+    Return monotonic time in milliseconds
+*/
+double Now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+/*
+    Return TRUE if the filename ends with the given extension
+*/
+BOOL HasExtension(const char * filename, const char * extension)
+{
+    size_t length = strlen(filename);
+    size_t extLength = strlen(extension);
+    return length >= extLength && strcmp(filename + length - extLength, extension) == 0;
+}
+
+/*
+    Add a copy of a file name to the list
+    Return FALSE if memory could not be allocated
+*/
+BOOL AddMapName(MapList * list, const char * directory, const char * name)
+{
+    if(list->count == list->capacity)
     {
-        newDistance = FALSE;
-        distanceCount++;
-        int distanceMax = size - index; // Offset by the starting index (see below for more info)
+        list->capacity = list->capacity ? list->capacity * 2 : 16;
+        if(!ResizeArray((void **)&list->names, list->capacity, sizeof(char *)))
+        {
+            list->names = NULL;
+            list->count = 0;
+            list->capacity = 0;
+            return FALSE;
+        }
+    }
+    size_t length = (directory ? strlen(directory) + 1 : 0) + strlen(name) + 1;
+    char * path = (char *)malloc(length);
+    if(!path)
+    {
+        return FALSE;
+    }
+    if(directory)
+    {
+        snprintf(path, length, "%s/%s", directory, name);
+    }
+    else
+    {
+        snprintf(path, length, "%s", name);
+    }
+    list->names[list->count++] = path;
+    return TRUE;
+}
 
-        for(int i = 0; i < distanceMax; i++)
+/*
+    qsort comparison of two file names
+*/
+int CompareNames(const void * a, const void * b)
+{
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/*
+    Add every map file (.txt or .bin) in a directory to the list, sorted by name
+    Return FALSE if the path is not a directory
+*/
+BOOL AddMapDirectory(MapList * list, const char * directory)
+{
+    int first = list->count;
+#ifdef _WIN32
+    char pattern[MAX_PATH];
+    snprintf(pattern, sizeof(pattern), "%s\\*", directory);
+    WIN32_FIND_DATAA entry;
+    HANDLE find = FindFirstFileA(pattern, &entry);
+    if(find == INVALID_HANDLE_VALUE)
+    {
+        return FALSE;
+    }
+    do
+    {
+        if(!(entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            && (HasExtension(entry.cFileName, ".txt") || HasExtension(entry.cFileName, ".bin")))
         {
-            x = distances[index].x;
-            y = distances[index].y;
-            Map_namespace.SetCell(map, x, y, distanceCount);
-            // North
-            if((y > 0) && Map_namespace.GetCell(map, x, y - 1) == FREE)
-            {
-                if(!ResizeArray((void **)&distances, ++size, sizeof(Node)))
-                {
-                    return FALSE;
-                }
-                distances[size - 1].x = x;
-                distances[size - 1].y = y - 1;
-                newDistance = TRUE;
-            }
-             // South
-            if(((y + 1) < map->height) && Map_namespace.GetCell(map, x, y + 1) == FREE)
-            {
-                if(!ResizeArray((void **)&distances, ++size, sizeof(Node)))
-                {
-                    return FALSE;
-                }
-                distances[size - 1].x = x;
-                distances[size - 1].y = y + 1;
-                newDistance = TRUE;
-            }
-            // East
-            if(((x + 1) < map->width) && Map_namespace.GetCell(map, x + 1, y) == FREE)
-            {
-                if(!ResizeArray((void **)&distances, ++size, sizeof(Node)))
-                {
-                    return FALSE;
-                }
-                distances[size - 1].x = x + 1;
-                distances[size - 1].y = y;
-                newDistance = TRUE;
-            }
-            // West
-            if((x > 0) && Map_namespace.GetCell(map, x - 1, y) == FREE)
-            {
-                if(!ResizeArray((void **)&distances, ++size, sizeof(Node)))
-                {
-                    return FALSE;
-                }
-                distances[size - 1].x = x - 1;
-                distances[size - 1].y = y;
-                newDistance = TRUE;
-            }
-            // Destination. Break out of the loop
-            if(y == map->height - 1 && x == map->end)
-            {
-                newDistance = FALSE;
-                break;
-            }
+            AddMapName(list, directory, entry.cFileName);
+        }
+    } while(FindNextFileA(find, &entry));
+    FindClose(find);
+#else
+    DIR * dir = opendir(directory);
+    if(!dir)
+    {
+        return FALSE;
+    }
+    struct dirent * entry;
+    while((entry = readdir(dir)) != NULL)
+    {
+        if(entry->d_name[0] != '.' && (HasExtension(entry->d_name, ".txt") || HasExtension(entry->d_name, ".bin")))
+        {
+            AddMapName(list, directory, entry->d_name);
+        }
+    }
+    closedir(dir);
+#endif
+    qsort(list->names + first, list->count - first, sizeof(char *), CompareNames);
+    return TRUE;
+}
+
+/*
+    Free the file names
+*/
+void DestroyMapList(MapList * list)
+{
+    for(int i = 0; i < list->count; i++)
+    {
+        free(list->names[i]);
+    }
+    free(list->names);
+    list->names = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+/*
+    Outcome of solving one map of a batch
+*/
+typedef struct MapResult
+{
+    BOOL loaded;
+    BOOL solved;
+    BOOL saved;         // Saved to the output directory, or no output directory given
+    int width;
+    int height;
+    int path;           // Number of PATH cells
+    size_t expanded;    // Nodes expanded by the solver
+    double loadTime;    // Milliseconds
+    double solveTime;   // Milliseconds
+} MapResult;
+
+/*
+    Shared state of a batch, read by every worker
+    Every thread owns one arena, so workers never share scratch memory or contend on malloc
+*/
+typedef struct Batch
+{
+    MapList * list;
+    MapResult * results;    // One per map, in input order
+    Arena * arenas;         // One per thread
+    const char * outputDir; // Directory to save solved maps to, NULL to not save
+    const SolverInfo * solver;
+    unsigned int seed;
+    BOOL reachable;         // Label the components first and skip maps whose end cannot be reached
+} Batch;
+
+/*
+    Save a solved map as <outputDir>/<input name without extension>.bin
+*/
+BOOL SaveSolvedMap(Map * map, const char * outputDir, const char * filename)
+{
+    const char * name = strrchr(filename, '/');
+    name = name ? name + 1 : filename;
+    const char * extension = strrchr(name, '.');
+    int nameLength = extension ? (int)(extension - name) : (int)strlen(name);
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%.*s.bin", outputDir, nameLength, name);
+    return Map_namespace.SaveMapBinary(map, path);
+}
+
+/*
+    Pool task: load, solve and optionally save one map of the batch
+    The random generator is seeded from the map index, so start/end points of text maps
+    do not depend on which thread picks the map up or in which order
+*/
+void SolveBatchMap(void * context, int index, int thread)
+{
+    Batch * batch = (Batch *)context;
+    MapResult * result = &batch->results[index];
+    Arena * arena = &batch->arenas[thread];
+    ArenaMark mark = Arena_namespace.Mark(arena);
+    SeedRandom((uint64_t)batch->seed + index);
 
-            // Best approach would be to have a linked list and simply pop the first element from the queue
-            // I am too lazy and using a growing array instead
-            distances[index].x = -1;
-            distances[index++].y = -1;
+    Map map;
+    double start = Now();
+    result->loaded = Map_namespace.LoadMapArena(&map, batch->list->names[index], batch->solver->format, arena);
+    if(result->loaded)
+    {
+        SolverStats stats = {0};
+        double loaded = Now();
+        BOOL reachable = TRUE;
+        if(batch->reachable)
+        {
+            LabelPlane plane;
+            Node startNode = {map.start, 0};
+            Node endNode = {map.end, map.height - 1};
+            reachable = !Labels_namespace.Build(&plane, &map) || Labels_namespace.Connected(&plane, startNode, endNode);
+            Labels_namespace.Destroy(&plane);
+        }
+        result->solved = reachable && batch->solver->solve(&map, &stats);
+        double finished = Now();
+        result->width       = map.width;
+        result->height      = map.height;
+        result->loadTime    = loaded - start;
+        result->solveTime   = finished - loaded;
+        result->expanded    = stats.expanded;
+        if(result->solved)
+        {
+            result->path = Solver_namespace.PathLength(&map);
+            result->saved = !batch->outputDir || SaveSolvedMap(&map, batch->outputDir, batch->list->names[index]);
         }
+        Map_namespace.Destroy(&map);
     }
+    Arena_namespace.Reset(arena, mark);
+}
 
-    // Walk back towards the exit, marking nodes as solution on the way
-    x = map->end;
-    y = map->height - 1;
-    distanceCount = Map_namespace.GetCell(map, x, y);
-    while(distanceCount != 3)
+/*
+    Solve every map in the list on a pool of threads without rendering, then print the path length
+    and timings of each map in input order, followed by the aggregate throughput
+    solver      = solver to run on every map
+    threadCount = number of threads, 0 for one per core
+    outputDir   = directory to save solved maps to, NULL to not save
+    quiet       = only print the totals
+    reachable   = check the end can be reached before searching, from a component labelling
+    Return the number of maps that could not be loaded, solved or saved
+*/
+int SolveBatch(MapList * list, const SolverInfo * solver, int threadCount, const char * outputDir, unsigned int seed, BOOL quiet,
+    BOOL reachable)
+{
+    Pool pool;
+    if(!Pool_namespace.Init(&pool, threadCount))
     {
-        Map_namespace.SetCell(map, x, y, PATH);
-        distanceCount--;
-        // North
-        if((y > 0) && (distanceCount == Map_namespace.GetCell(map, x, y - 1)))
+        return list->count;
+    }
+    Batch batch;
+    batch.list      = list;
+    batch.results   = (MapResult *)calloc(list->count ? list->count : 1, sizeof(MapResult));
+    batch.arenas    = (Arena *)calloc(pool.threadCount, sizeof(Arena));
+    batch.outputDir = outputDir;
+    batch.solver    = solver;
+    batch.seed      = seed;
+    batch.reachable = reachable;
+    if(!batch.results || !batch.arenas)
+    {
+        free(batch.results);
+        free(batch.arenas);
+        Pool_namespace.Destroy(&pool);
+        return list->count;
+    }
+    for(int i = 0; i < pool.threadCount; i++)
+    {
+        // Maps that do not fit fall back to malloc
+        Arena_namespace.Init(&batch.arenas[i], BATCH_ARENA_SIZE);
+    }
+
+    double start = Now();
+    Pool_namespace.Run(&pool, list->count, SolveBatchMap, &batch);
+    double wallTime = Now() - start;
+
+    int solved = 0;
+    int failed = 0;
+    double cells = 0;
+    double expanded = 0;
+    double loadTime = 0;
+    double solveTime = 0;
+    if(!quiet)
+    {
+        printf("%-40s %11s %8s %10s %10s %10s\n", "map", "size", "path", "expanded", "load ms", "solve ms");
+    }
+    for(int i = 0; i < list->count; i++)
+    {
+        MapResult * result = &batch.results[i];
+        if(!result->loaded)
         {
-            y--;
+            printf("%-40s failed to load\n", list->names[i]);
+            failed++;
         }
-        // South
-        else if(((y + 1) < map->height) && (distanceCount == Map_namespace.GetCell(map, x, y + 1)))
+        else if(!result->solved)
         {
-            y++;
+            printf("%-40s no path\n", list->names[i]);
+            failed++;
         }
-        // East
-        else if(((x + 1) < map->width) && (distanceCount == Map_namespace.GetCell(map, x + 1, y)))
+        else if(!result->saved)
         {
-            x++;
+            printf("%-40s failed to save\n", list->names[i]);
+            failed++;
         }
-        // West
-        else if((x > 0) && (distanceCount == Map_namespace.GetCell(map, x - 1, y)))
+        else
         {
-            x--;
+            solved++;
+            cells += (double)result->width * result->height;
+            expanded += (double)result->expanded;
+            loadTime += result->loadTime;
+            solveTime += result->solveTime;
+            if(!quiet)
+            {
+                char size[32];
+                snprintf(size, sizeof(size), "%dx%d", result->width, result->height);
+                printf("%-40s %11s %8d %10zu %10.3f %10.3f\n", list->names[i], size,
+                    result->path, result->expanded, result->loadTime, result->solveTime);
+            }
         }
     }
 
-    // Cleanup.
-    // Scan each cell and if not a wall or a path, set to free cell
-    for(int i = 0; i < map->width; i++)
+    printf("%d maps solved, %d failed, %.0f cells, %.0f expanded, %d threads, %s solver\n",
+        solved, failed, cells, expanded, pool.threadCount, solver->name);
+    if(solved)
     {
-        for(int ii = 0; ii < map->height; ii++)
+        // solve and load+solve are summed over all threads, wall is the elapsed time of the whole batch
+        printf("solve:      %10.3f ms %12.1f maps/sec %14.0f cells/sec\n",
+            solveTime, solved * 1000.0 / solveTime, cells * 1000.0 / solveTime);
+        printf("load+solve: %10.3f ms %12.1f maps/sec %14.0f cells/sec\n", loadTime + solveTime,
+            solved * 1000.0 / (loadTime + solveTime), cells * 1000.0 / (loadTime + solveTime));
+        printf("wall:       %10.3f ms %12.1f maps/sec %14.0f cells/sec\n",
+            wallTime, solved * 1000.0 / wallTime, cells * 1000.0 / wallTime);
+    }
+
+    for(int i = 0; i < pool.threadCount; i++)
+    {
+        Arena_namespace.Destroy(&batch.arenas[i]);
+    }
+    free(batch.arenas);
+    free(batch.results);
+    Pool_namespace.Destroy(&pool);
+    return failed;
+}
+
+/*
+    Print the batch mode options
+*/
+void PrintBatchUsage(void)
+{
+    printf("maze_solver [-p steps] [-t ms] to solve map.txt in a window\n");
+    printf("maze_solver [-q] [-r] [-s seed] [-j threads] [-o outputDir] [-a solver] <map file or directory>...\n");
+}
+
+/*
+    Headless batch mode: maze_solver [-q] [-r] [-s seed] [-j threads] [-o outputDir] [-a solver] <map file or directory>...
+    Directories are searched for .txt and .bin maps. Text maps get random start/end points,
+    -s makes them reproducible. -j defaults to one thread per core.
+    -o saves every solved map, with its path, as a binary map
+    -a picks the solver by name: bfs (default), bitboard, bidirectional, astar, jps,
+    parallel (every core on one map with -j 1, one thread per map when -j runs several)
+    dijkstra (cheapest path on maps with a cost plane), compact (2 bits of scratch per cell)
+    or filling (dead end filling, then a search of what is left)
+    -r labels the connected components of every map first, so maps without a path are reported
+    without a search. Costs one pass over the rows of the solvable maps
+    first = index of the first argument after the pacer options, which batch mode ignores
+*/
+int BatchMain(int argc, char * argv[], int first)
+{
+    MapList list = {NULL, 0, 0};
+    BOOL quiet = FALSE;
+    BOOL reachable = FALSE;
+    int threadCount = 0;
+    const char * outputDir = NULL;
+    const SolverInfo * solver = Solver_namespace.Find("bfs");
+    time_t t;
+    unsigned int seed = (unsigned) time(&t);
+
+    for(int i = first; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-q") == 0)
+        {
+            quiet = TRUE;
+        }
+        else if(strcmp(argv[i], "-r") == 0)
+        {
+            reachable = TRUE;
+        }
+        else if(strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+        {
+            seed = (unsigned) strtoul(argv[++i], NULL, 10);
+        }
+        else if(strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+        {
+            threadCount = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        {
+            outputDir = argv[++i];
+        }
+        else if(strcmp(argv[i], "-a") == 0 && i + 1 < argc)
         {
-            if(Map_namespace.GetCell(map, i, ii) != WALL && Map_namespace.GetCell(map, i, ii) != PATH)
+            solver = Solver_namespace.Find(argv[++i]);
+            if(!solver)
             {
-                Map_namespace.SetCell(map, i, ii, FREE);
+                int count;
+                const SolverInfo * solvers = Solver_namespace.List(&count);
+                printf("Unknown solver %s, use", argv[i]);
+                for(int ii = 0; ii < count; ii++)
+                {
+                    printf(" %s", solvers[ii].name);
+                }
+                printf("\n");
+                DestroyMapList(&list);
+                return -4;
             }
         }
+        else if(argv[i][0] == '-')
+        {
+            // Unknown option, or an option missing its value
+            printf("Unknown option %s\n", argv[i]);
+            PrintBatchUsage();
+            DestroyMapList(&list);
+            return -5;
+        }
+        else if(!AddMapDirectory(&list, argv[i]) && !AddMapName(&list, NULL, argv[i]))
+        {
+            DestroyMapList(&list);
+            return -3;
+        }
     }
-    return TRUE;
+
+    int failed = SolveBatch(&list, solver, threadCount, outputDir, seed, quiet, reachable);
+    DestroyMapList(&list);
+    return failed ? 1 : 0;
 }
 
 //The parameters in the main function cannot be omitted, or an error will be reported
+//With map files or directories as arguments the maps are solved headless, without SDL
+//Otherwise map.txt is solved in a window: maze_solver [-p steps per frame] [-t ms of work per frame]
 int main(int arg, char *argv[])
 {
+    Map map;
+    View view;
+    view.map = &map;
+    Pacer pacer;
+    int first = Pacer_namespace.Init(&pacer, arg, argv, FPS_COUNT, DrawView, &view);
+    if(first < arg)
+    {
+        return BatchMain(arg, argv, first);
+    }
+
     SDL_Window   * pWindow   = NULL;
     SDL_Surface  * pSurface  = NULL;
     SDL_Renderer * pRenderer = NULL;
@@ -369,13 +630,13 @@ int main(int arg, char *argv[])
 
     // Seed the random generator
     time_t t;
-    srand((unsigned) time(&t));
+    SeedRandom((unsigned) time(&t));
 
     // Load map
-    Map map;
-    if(Map_namespace.LoadMap(&map, "map.txt"))
+    if(Map_namespace.LoadMap(&map, "map.txt") && Grid_namespace.Init(&view.grid, pRenderer, map.width, map.height))
     {
-        SolveRealtime(&map, pRenderer); // Main loop inside
+        SolveRealtime(&map, &pacer, &view.grid); // Main loop inside
+        Grid_namespace.Destroy(&view.grid);
     }
 
     // Cleanup
@@ -11,9 +11,189 @@
 #define screenWidth 1920
 #define screenHeight 1080
 
+/*
+    Position and view direction of the player
+    plane = camera plane, perpendicular to the direction. Its length sets the field of view
+*/
+typedef struct Camera
+{
+    double posX;
+    double posY;
+    double dirX;
+    double dirY;
+    double planeX;
+    double planeY;
+} Camera;
+
+/*
+    Cast one ray per screen column and draw the wall slice it hits
+    w, h      = size of the view in pixels
+    pRenderer = renderer to draw to, NULL to only cast the rays
+*/
+void RenderWalls(Map * map, const Camera * camera, SDL_Renderer * pRenderer, int w, int h)
+{
+    for(int x = 0; x < w; x++)
+    {
+        double cameraX = 2 * x / (double)w - 1;
+        double rayDirX = camera->dirX + camera->planeX * cameraX;
+        double rayDirY = camera->dirY + camera->planeY * cameraX;
+
+        int mapX = (int)camera->posX;
+        int mapY = (int)camera->posY;
+
+        double sideDistX;
+        double sideDistY;
+
+        double deltaDistX = fabs(1.0 / rayDirX);
+        double deltaDistY = fabs(1.0 / rayDirY);
+        double perpWallDist;
+
+        int stepX;
+        int stepY;
+
+        int hit = 0;
+        int side;
+
+        if(rayDirX < 0)
+        {
+            stepX = -1;
+            sideDistX = (camera->posX - mapX) * deltaDistX;
+        }
+        else
+        {
+            stepX = 1;
+            sideDistX = (mapX + 1.0 - camera->posX) * deltaDistX;
+        }
+
+        if(rayDirY < 0)
+        {
+            stepY = -1;
+            sideDistY = (camera->posY - mapY) * deltaDistY;
+        }
+        else
+        {
+            stepY = 1;
+            sideDistY = (mapY + 1.0 - camera->posY) * deltaDistY;
+        }
+
+        while(!hit)
+        {
+            if(sideDistX < sideDistY)
+            {
+                sideDistX += deltaDistX;
+                mapX += stepX;
+                side = 0;
+            }
+            else
+            {
+                sideDistY += deltaDistY;
+                mapY += stepY;
+                side = 1;
+            }
+
+            hit = MapGet(map, mapX, mapY);
+        }
+
+        perpWallDist = (side == 0) 
+            ? (mapX - camera->posX + (1 - stepX) / 2) / rayDirX 
+            : (mapY - camera->posY + (1 - stepY) / 2) / rayDirY;
+
+        int lineHeight = (int)(h / perpWallDist);
+
+        int drawStart = -lineHeight / 2 + h / 2;
+        if(drawStart < 0)
+        {
+            drawStart = 0;
+        }
+        int drawEnd = lineHeight / 2 + h / 2;
+        if(drawEnd >= h)
+        {
+            drawEnd = h - 1;
+        }
+
+        if(pRenderer)
+        {
+            SDL_SetRenderDrawColor(pRenderer, (side == 1) ? 128 : 255, 0, 0, SDL_ALPHA_OPAQUE);
+            SDL_RenderDrawLineF(pRenderer, x, drawStart, x, drawEnd);
+        }
+    }
+}
+
+#ifdef BENCHMARK
+#include "./common/bench.h"
+
+/*
+    State of the frame benchmarks: a map, a fixed camera and an offscreen software renderer
+*/
+typedef struct FrameBench
+{
+    Map map;
+    Camera camera;
+    SDL_Renderer * pRenderer;
+} FrameBench;
+
+void Frame(void * context)
+{
+    FrameBench * bench = (FrameBench *)context;
+    SDL_SetRenderDrawColor(bench->pRenderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
+    SDL_RenderClear(bench->pRenderer);
+    RenderWalls(&bench->map, &bench->camera, bench->pRenderer, screenWidth, screenHeight);
+}
+
+void Rays(void * context)
+{
+    FrameBench * bench = (FrameBench *)context;
+    RenderWalls(&bench->map, &bench->camera, NULL, screenWidth, screenHeight);
+}
+
+/*
+    Benchmark one frame, drawn into an offscreen surface so no window is needed, and the ray casting alone
+    raycaster [benchmark options] [map]
+*/
+int main(int arg, char *argv[])
+{
+    int first = Bench_namespace.Init(arg, argv, "raycaster");
+    if(first < 0)
+    {
+        return 1;
+    }
+    FrameBench bench;
+    if(!Map_namespace.LoadMapFormat(&bench.map, (first < arg) ? argv[first] : "map.txt", MAP_PACKED))
+    {
+        return 2;
+    }
+    SDL_Surface * pSurface = SDL_CreateRGBSurfaceWithFormat(0, screenWidth, screenHeight, 32, SDL_PIXELFORMAT_ARGB8888);
+    bench.pRenderer = pSurface ? SDL_CreateSoftwareRenderer(pSurface) : NULL;
+    if(!bench.pRenderer)
+    {
+        Map_namespace.Destroy(&bench.map);
+        return 3;
+    }
+
+    // Just inside the entrance, looking into the maze
+    Camera camera = {bench.map.start + 0.5, 1.5, 0, 1, -0.66, 0};
+    bench.camera = camera;
+    const Benchmark benchmarks[] =
+    {
+        {"frame", NULL, Frame, &bench, 1},
+        {"rays",  NULL, Rays,  &bench, 1},
+    };
+    for(size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++)
+    {
+        Bench_namespace.Run(&benchmarks[i]);
+    }
+
+    SDL_DestroyRenderer(bench.pRenderer);
+    SDL_FreeSurface(pSurface);
+    Map_namespace.Destroy(&bench.map);
+    return Bench_namespace.Finish();
+}
+#else
 //The parameters in the main function cannot be omitted, or an error will be reported
 int main(int arg, char *argv[])
 {
+    (void)arg;
+    (void)argv;
     SDL_Window   * pWindow   = NULL;
     SDL_Surface  * pSurface  = NULL;
     SDL_Renderer * pRenderer = NULL;
@@ -30,7 +210,7 @@ int main(int arg, char *argv[])
     }
 
     Map map;
-    int quit = !Map_namespace.LoadMap(&map, "map.txt");
+    int quit = !Map_namespace.LoadMapFormat(&map, "map.txt", MAP_PACKED); // Only walls are needed for casting
     int showMaze = 0;
 
     // Raycaster setup
@@ -49,88 +229,8 @@ int main(int arg, char *argv[])
         SDL_SetRenderDrawColor(pRenderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
         SDL_RenderClear(pRenderer);
 
-        for(int x = 0; x < w; x++)
-        {
-            double cameraX = 2 * x / (double)w - 1;
-            double rayDirX = dirX + planeX * cameraX;
-            double rayDirY = dirY + planeY * cameraX;
-
-            int mapX = (int)posX;
-            int mapY = (int)posY;
-
-            double sideDistX;
-            double sideDistY;
-
-            double deltaDistX = fabs(1.0 / rayDirX);
-            double deltaDistY = fabs(1.0 / rayDirY);
-            double perpWallDist;
-
-            int stepX;
-            int stepY;
-
-            int hit = 0;
-            int side;
-
-            if(rayDirX < 0)
-            {
-                stepX = -1;
-                sideDistX = (posX - mapX) * deltaDistX;
-            }
-            else
-            {
-                stepX = 1;
-                sideDistX = (mapX + 1.0 - posX) * deltaDistX;
-            }
-
-            if(rayDirY < 0)
-            {
-                stepY = -1;
-                sideDistY = (posY - mapY) * deltaDistY;
-            }
-            else
-            {
-                stepY = 1;
-                sideDistY = (mapY + 1.0 - posY) * deltaDistY;
-            }
-
-            while(!hit)
-            {
-                if(sideDistX < sideDistY)
-                {
-                    sideDistX += deltaDistX;
-                    mapX += stepX;
-                    side = 0;
-                }
-                else
-                {
-                    sideDistY += deltaDistY;
-                    mapY += stepY;
-                    side = 1;
-                }
-
-                hit = Map_namespace.GetCell(&map, mapX, mapY);
-            }
-
-            perpWallDist = (side == 0) 
-                ? (mapX - posX + (1 - stepX) / 2) / rayDirX 
-                : (mapY - posY + (1 - stepY) / 2) / rayDirY;
-
-            int lineHeight = (int)(h / perpWallDist);
-
-            int drawStart = -lineHeight / 2 + h / 2;
-            if(drawStart < 0)
-            {
-                drawStart = 0;
-            }
-            int drawEnd = lineHeight / 2 + h / 2;
-            if(drawEnd >= h)
-            {
-                drawEnd = h - 1;
-            }
-
-            SDL_SetRenderDrawColor(pRenderer, (side == 1) ? 128 : 255, 0, 0, SDL_ALPHA_OPAQUE);
-            SDL_RenderDrawLineF(pRenderer, x, drawStart, x, drawEnd);
-        }
+        Camera camera = {posX, posY, dirX, dirY, planeX, planeY};
+        RenderWalls(&map, &camera, pRenderer, w, h);
 
         // Draw maze
         if(showMaze)
@@ -196,22 +296,22 @@ int main(int arg, char *argv[])
         // Movement forward backward
         if(keys[SDL_SCANCODE_W])
         {
-            if(!Map_namespace.GetCell(&map, (int)(posX + dirX * moveSpeed), (int)posY))
+            if(!MapGet(&map, (int)(posX + dirX * moveSpeed), (int)posY))
             {
                 posX += dirX * moveSpeed;
             }
-            if(!Map_namespace.GetCell(&map, (int)posX, (int)(posY + dirY * moveSpeed)))
+            if(!MapGet(&map, (int)posX, (int)(posY + dirY * moveSpeed)))
             {
                 posY += dirY * moveSpeed;
             }
         }
         else if(keys[SDL_SCANCODE_S])
         {
-            if(!Map_namespace.GetCell(&map, (int)(posX - dirX * moveSpeed), (int)posY))
+            if(!MapGet(&map, (int)(posX - dirX * moveSpeed), (int)posY))
             {
                 posX -= dirX * moveSpeed;
             }
-            if(!Map_namespace.GetCell(&map,(int)posX, (int)(posY - dirY * moveSpeed)))
+            if(!MapGet(&map,(int)posX, (int)(posY - dirY * moveSpeed)))
             {
                 posY -= dirY * moveSpeed;
             }
@@ -220,22 +320,22 @@ int main(int arg, char *argv[])
         // Movement sideways
         if(keys[SDL_SCANCODE_A])
         {
-            if(!Map_namespace.GetCell(&map, (int)(posX + (dirY / 2) * moveSpeed), (int)posY))
+            if(!MapGet(&map, (int)(posX + (dirY / 2) * moveSpeed), (int)posY))
             {
                 posX += (dirY / 2) * moveSpeed;
             }
-            if(!Map_namespace.GetCell(&map, (int)posX, (int)(posY + (dirX / 2) * moveSpeed)))
+            if(!MapGet(&map, (int)posX, (int)(posY + (dirX / 2) * moveSpeed)))
             {
                 posY += (dirX / 2) * moveSpeed;
             }
         }
         else if(keys[SDL_SCANCODE_D])
         {
-            if(!Map_namespace.GetCell(&map, (int)(posX - (dirY / 2) * moveSpeed), (int)posY))
+            if(!MapGet(&map, (int)(posX - (dirY / 2) * moveSpeed), (int)posY))
             {
                 posX -= (dirY / 2) * moveSpeed;
             }
-            if(!Map_namespace.GetCell(&map,(int)posX, (int)(posY - (dirX / 2) * moveSpeed)))
+            if(!MapGet(&map,(int)posX, (int)(posY - (dirX / 2) * moveSpeed)))
             {
                 posY -= (dirX / 2) * moveSpeed;
             }
@@ -283,4 +383,5 @@ int main(int arg, char *argv[])
     SDL_Quit();
 
     return 0;
-}
\ No newline at end of file
+}
+#endif // BENCHMARK